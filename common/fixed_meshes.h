@@ -0,0 +1,175 @@
+#ifndef FIXED_MESHES_H
+#define FIXED_MESHES_H
+
+#include <array>
+#include <cstddef>
+
+// Small meshes with fixed segment counts generated at compile time.
+//
+// The generators are constexpr and return std::array data, so a mesh
+// assigned to a constexpr variable is built by the compiler and stored in
+// the read-only data of the binary; startup only copies it into the vertex
+// type of the renderer. The shapes, texture coordinates and winding match
+// surface_generators.h.
+
+namespace fixed_meshes {
+
+struct FixedVertex {
+    float position[3];
+    float normal[3];
+    float texture_coordinates[2];
+};
+
+template<size_t VertexCount, size_t IndexCount>
+struct FixedMesh {
+    std::array<FixedVertex, VertexCount> vertices;
+    std::array<unsigned int, IndexCount> indices;
+};
+
+namespace detail {
+
+constexpr double PI{ 3.14159265358979323846 };
+
+// Taylor series around zero after reducing the angle to [-pi, pi]; the
+// error is below float precision over that range.
+constexpr double sin(double x)
+{
+    while (x > PI) {
+        x -= 2.0 * PI;
+    }
+    while (x < -PI) {
+        x += 2.0 * PI;
+    }
+
+    double term{ x }, sum{ x };
+    for (int n = 1; n < 12; ++n) {
+        term *= -x * x / static_cast<double>((2 * n) * (2 * n + 1));
+        sum += term;
+    }
+
+    return sum;
+}
+
+constexpr double cos(double x)
+{
+    return sin(x + 0.5 * PI);
+}
+
+constexpr FixedVertex make_vertex(double x, double y, double z, double nx, double ny, double nz, double u, double v)
+{
+    return FixedVertex{
+        { static_cast<float>(x), static_cast<float>(y), static_cast<float>(z) },
+        { static_cast<float>(nx), static_cast<float>(ny), static_cast<float>(nz) },
+        { static_cast<float>(u), static_cast<float>(v) }
+    };
+}
+
+}
+
+// A rectangle in the XY plane facing +Z.
+constexpr FixedMesh<4, 6> make_quad(float width, float height)
+{
+    double half_width{ 0.5 * width }, half_height{ 0.5 * height };
+
+    return FixedMesh<4, 6>{
+        {
+            detail::make_vertex(-half_width, -half_height, 0.0, 0.0, 0.0, 1.0, 0.0, 1.0),
+            detail::make_vertex(half_width, -half_height, 0.0, 0.0, 0.0, 1.0, 1.0, 1.0),
+            detail::make_vertex(-half_width, half_height, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0),
+            detail::make_vertex(half_width, half_height, 0.0, 0.0, 0.0, 1.0, 1.0, 0.0)
+        },
+        { 0, 1, 2, 1, 3, 2 }
+    };
+}
+
+// A box around the origin with one quad per side.
+constexpr FixedMesh<24, 36> make_box(float width, float height, float depth)
+{
+    FixedMesh<24, 36> mesh{};
+
+    // Center and the two edge directions of every side, as in surface_generators::generate_box.
+    constexpr int sides[6][9]{
+        { 0, 0, 1, 1, 0, 0, 0, 1, 0 },
+        { 0, 0, -1, -1, 0, 0, 0, 1, 0 },
+        { 1, 0, 0, 0, 0, -1, 0, 1, 0 },
+        { -1, 0, 0, 0, 0, 1, 0, 1, 0 },
+        { 0, 1, 0, 1, 0, 0, 0, 0, -1 },
+        { 0, -1, 0, 1, 0, 0, 0, 0, 1 }
+    };
+    const double size[3]{ width, height, depth };
+
+    for (size_t side = 0; side < 6; ++side) {
+        const int* axes = sides[side];
+        for (size_t corner = 0; corner < 4; ++corner) {
+            double u{ static_cast<double>(corner & 1U) }, v{ static_cast<double>(corner >> 1U) };
+            double position[3]{};
+            for (size_t axis = 0; axis < 3; ++axis) {
+                position[axis] = size[axis] * (0.5 * axes[axis] + (u - 0.5) * axes[3 + axis] + (v - 0.5) * axes[6 + axis]);
+            }
+            mesh.vertices[side * 4 + corner] = detail::make_vertex(
+                position[0], position[1], position[2], axes[0], axes[1], axes[2], u, 1.0 - v
+            );
+        }
+
+        auto first = static_cast<unsigned int>(side * 4);
+        const unsigned int quad[6]{ 0, 1, 2, 1, 3, 2 };
+        for (size_t i = 0; i < 6; ++i) {
+            mesh.indices[side * 6 + i] = first + quad[i];
+        }
+    }
+
+    return mesh;
+}
+
+template<unsigned int Columns, unsigned int Rows>
+using FixedSphere = FixedMesh<(Columns + 1) * (Rows + 1), Columns * (2 * Rows - 2) * 3>;
+
+// A UV sphere around the Y axis without the degenerate triangles at its
+// poles.
+template<unsigned int Columns, unsigned int Rows>
+constexpr FixedSphere<Columns, Rows> make_sphere(float radius)
+{
+    static_assert(Columns >= 3 && Rows >= 2, "a sphere needs at least three columns and two rows");
+
+    FixedSphere<Columns, Rows> mesh{};
+
+    size_t vertex{ 0 };
+    for (unsigned int row = 0; row <= Rows; ++row) {
+        double v{ static_cast<double>(row) / Rows };
+        double phi{ v * detail::PI };
+        double sin_phi{ detail::sin(phi) }, cos_phi{ detail::cos(phi) };
+        for (unsigned int column = 0; column <= Columns; ++column) {
+            double u{ static_cast<double>(column) / Columns };
+            double theta{ u * 2.0 * detail::PI };
+            double x{ detail::cos(theta) * sin_phi }, y{ cos_phi }, z{ detail::sin(theta) * sin_phi };
+            mesh.vertices[vertex++] = detail::make_vertex(x * radius, y * radius, z * radius, x, y, z, 1.0 - u, v);
+        }
+    }
+
+    size_t index{ 0 };
+    for (unsigned int row = 0; row < Rows; ++row) {
+        unsigned int row_start{ row * (Columns + 1) };
+        if (row != 0) {
+            for (unsigned int column = 0; column < Columns; ++column) {
+                unsigned int a{ row_start + column };
+                mesh.indices[index++] = a;
+                mesh.indices[index++] = a + 1;
+                mesh.indices[index++] = a + Columns + 1;
+            }
+        }
+        if (row != Rows - 1) {
+            for (unsigned int column = 0; column < Columns; ++column) {
+                unsigned int a{ row_start + column };
+                mesh.indices[index++] = a + 1;
+                mesh.indices[index++] = a + Columns + 2;
+                mesh.indices[index++] = a + Columns + 1;
+            }
+        }
+    }
+
+    return mesh;
+}
+
+}
+
+#endif
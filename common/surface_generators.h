@@ -0,0 +1,680 @@
+#ifndef SURFACE_GENERATORS_H
+#define SURFACE_GENERATORS_H
+
+#include "fixed_meshes.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Geometry generators shared by the labs.
+//
+// A surface maps (u, v) in [0, 1] x [0, 1] to a position, a normal and
+// texture coordinates. generate_surface samples it on a grid of columns x
+// rows cells. It writes the vertices in a layout chosen at compile time and
+// indices for a topology chosen at compile time. Both buffers are sized
+// exactly before they are filled, and nothing is decided per vertex.
+//
+// The layouts take the asr::Vertex of the asr version a lab is built
+// against, so one header serves all of them. Grids are wound
+// counterclockwise when u runs along the first axis of the surface and v
+// along the second: for the revolved shapes, u goes around the Y axis and v
+// from top to bottom. A surface whose first or last row of vertices meets in
+// a single point (the poles of a sphere, the center of a disc) declares it,
+// and the degenerate triangles of that row are not emitted.
+
+namespace surface_generators {
+
+constexpr float PI{ 3.14159265358979323846f };
+constexpr float TWO_PI{ 2.0f * PI };
+
+template<typename Vertex>
+using GeometryData = std::pair<std::vector<Vertex>, std::vector<unsigned int>>;
+
+struct SurfacePoint {
+    glm::vec3 position;
+    glm::vec3 normal;
+    glm::vec2 texture_coordinates;
+};
+
+// Vertex layouts
+
+// asr 1.1: position and color.
+template<typename Vertex>
+struct PositionColor {
+    typedef Vertex vertex_type;
+
+    static Vertex make(const SurfacePoint& point, const glm::vec4& color)
+    {
+        return Vertex{ point.position.x, point.position.y, point.position.z, color.r, color.g, color.b, color.a };
+    }
+};
+
+// asr 1.2: position, color and texture coordinates.
+template<typename Vertex>
+struct PositionColorTexture {
+    typedef Vertex vertex_type;
+
+    static Vertex make(const SurfacePoint& point, const glm::vec4& color)
+    {
+        return Vertex{
+            point.position.x, point.position.y, point.position.z,
+            color.r, color.g, color.b, color.a,
+            point.texture_coordinates.x, point.texture_coordinates.y
+        };
+    }
+};
+
+// asr 1.3: position, normal, color and texture coordinates.
+template<typename Vertex>
+struct PositionNormalColorTexture {
+    typedef Vertex vertex_type;
+
+    static Vertex make(const SurfacePoint& point, const glm::vec4& color)
+    {
+        return Vertex{
+            point.position.x, point.position.y, point.position.z,
+            point.normal.x, point.normal.y, point.normal.z,
+            color.r, color.g, color.b, color.a,
+            point.texture_coordinates.x, point.texture_coordinates.y
+        };
+    }
+};
+
+// Topologies
+
+struct TriangleTopology { };
+
+struct PointTopology { };
+
+// Triangles that share no vertices. The color of every corner is replaced by
+// one of (1, 0, 0), (0, 1, 0) and (0, 0, 1), so a fragment shader receives
+// its barycentric coordinates and can draw the edges in the same pass as the
+// faces, without a second geometry for them.
+struct BarycentricTopology { };
+
+// Every row of cells as a strip, down the rows, joined by two repeated
+// indices. GL 2 and GLES 2 have no primitive restart, so the joins and the
+// surfaces appended to one geometry are connected by degenerate triangles,
+// which are culled before rasterization. A grid costs about two indices per
+// cell instead of six.
+struct TriangleStripTopology { };
+
+// The cells of a single row around its collapsed last row, such as a disc,
+// as one fan from the collapsed point: columns + 2 indices instead of three
+// per cell. The collapsed point is a single vertex instead of one per column.
+// A fan cannot be continued, so it has to be the only surface of its
+// geometry.
+struct TriangleFanTopology { };
+
+// Surfaces
+
+// A rectangle spanned by two edge vectors around its center. The normal is
+// cross(u_axis, v_axis).
+struct Patch {
+    static constexpr bool first_row_collapsed{ false };
+    static constexpr bool last_row_collapsed{ false };
+
+    glm::vec3 center;
+    glm::vec3 u_axis;
+    glm::vec3 v_axis;
+
+    SurfacePoint operator()(float u, float v) const
+    {
+        return SurfacePoint{
+            center + (u - 0.5f) * u_axis + (v - 0.5f) * v_axis,
+            glm::normalize(glm::cross(u_axis, v_axis)),
+            glm::vec2{ u, 1.0f - v }
+        };
+    }
+};
+
+// A disc in the plane of two unit axes, from the rim (v = 0) to the
+// center. The normal is cross(x_axis, y_axis).
+struct Disc {
+    static constexpr bool first_row_collapsed{ false };
+    static constexpr bool last_row_collapsed{ true };
+
+    glm::vec3 center;
+    glm::vec3 x_axis;
+    glm::vec3 y_axis;
+    float radius;
+
+    SurfacePoint operator()(float u, float v) const
+    {
+        float theta{ u * TWO_PI };
+        float cos_theta{ std::cos(theta) }, sin_theta{ std::sin(theta) };
+        float distance{ (1.0f - v) * radius };
+
+        return SurfacePoint{
+            center + distance * (cos_theta * x_axis + sin_theta * y_axis),
+            glm::normalize(glm::cross(x_axis, y_axis)),
+            glm::vec2{ 0.5f + 0.5f * (1.0f - v) * cos_theta, 0.5f + 0.5f * (1.0f - v) * sin_theta }
+        };
+    }
+};
+
+struct Sphere {
+    static constexpr bool first_row_collapsed{ true };
+    static constexpr bool last_row_collapsed{ true };
+
+    float radius;
+
+    SurfacePoint operator()(float u, float v) const
+    {
+        float phi{ v * PI }, theta{ u * TWO_PI };
+        float sin_phi{ std::sin(phi) };
+        glm::vec3 normal{ std::cos(theta) * sin_phi, std::cos(phi), std::sin(theta) * sin_phi };
+
+        return SurfacePoint{ normal * radius, normal, glm::vec2{ 1.0f - u, v } };
+    }
+};
+
+// The side of a cylinder around the Y axis, centered on the origin.
+struct CylinderSide {
+    static constexpr bool first_row_collapsed{ false };
+    static constexpr bool last_row_collapsed{ false };
+
+    float radius;
+    float height;
+
+    SurfacePoint operator()(float u, float v) const
+    {
+        float theta{ u * TWO_PI };
+        glm::vec3 normal{ std::cos(theta), 0.0f, std::sin(theta) };
+
+        return SurfacePoint{
+            glm::vec3{ normal.x * radius, height * (0.5f - v), normal.z * radius }, normal, glm::vec2{ 1.0f - u, v }
+        };
+    }
+};
+
+// The side of a cone around the Y axis with its apex at the top.
+struct ConeSide {
+    static constexpr bool first_row_collapsed{ true };
+    static constexpr bool last_row_collapsed{ false };
+
+    float radius;
+    float height;
+
+    SurfacePoint operator()(float u, float v) const
+    {
+        float theta{ u * TWO_PI };
+        float cos_theta{ std::cos(theta) }, sin_theta{ std::sin(theta) };
+
+        return SurfacePoint{
+            glm::vec3{ cos_theta * radius * v, height * (0.5f - v), sin_theta * radius * v },
+            glm::normalize(glm::vec3{ cos_theta * height, radius, sin_theta * height }),
+            glm::vec2{ 1.0f - u, v }
+        };
+    }
+};
+
+// A torus around the Y axis; v goes around the tube starting outside.
+struct Torus {
+    static constexpr bool first_row_collapsed{ false };
+    static constexpr bool last_row_collapsed{ false };
+
+    float radius;
+    float tube_radius;
+
+    SurfacePoint operator()(float u, float v) const
+    {
+        float theta{ u * TWO_PI }, phi{ v * TWO_PI };
+        float cos_theta{ std::cos(theta) }, sin_theta{ std::sin(theta) };
+        float cos_phi{ std::cos(phi) }, sin_phi{ std::sin(phi) };
+        glm::vec3 normal{ cos_phi * cos_theta, -sin_phi, cos_phi * sin_theta };
+        float distance{ radius + tube_radius * cos_phi };
+
+        return SurfacePoint{
+            glm::vec3{ distance * cos_theta, -tube_radius * sin_phi, distance * sin_theta }, normal, glm::vec2{ 1.0f - u, v }
+        };
+    }
+};
+
+// A cylinder of the given height between two hemispheres. Rows are spread
+// evenly along the profile, so the caps and the side are equally dense.
+struct Capsule {
+    static constexpr bool first_row_collapsed{ true };
+    static constexpr bool last_row_collapsed{ true };
+
+    float radius;
+    float height;
+
+    SurfacePoint operator()(float u, float v) const
+    {
+        float quarter{ 0.5f * PI * radius };
+        float distance{ v * (2.0f * quarter + height) };
+
+        float phi{ 0.5f * PI }, center{ 0.0f };
+        if (distance < quarter) {
+            phi = distance / radius;
+            center = 0.5f * height;
+        } else if (distance > quarter + height) {
+            phi = 0.5f * PI + (distance - quarter - height) / radius;
+            center = -0.5f * height;
+        } else {
+            center = 0.5f * height - (distance - quarter);
+        }
+
+        float theta{ u * TWO_PI };
+        float sin_phi{ std::sin(phi) };
+        glm::vec3 normal{ std::cos(theta) * sin_phi, std::cos(phi), std::sin(theta) * sin_phi };
+
+        return SurfacePoint{ normal * radius + glm::vec3{ 0.0f, center, 0.0f }, normal, glm::vec2{ 1.0f - u, v } };
+    }
+};
+
+// Generation
+
+template<typename Surface>
+constexpr size_t surface_triangle_count(unsigned int columns, unsigned int rows)
+{
+    size_t collapsed{ (Surface::first_row_collapsed ? 1U : 0U) + (Surface::last_row_collapsed ? 1U : 0U) };
+    size_t triangles_per_column{ 2U * static_cast<size_t>(rows) };
+
+    return static_cast<size_t>(columns) * (triangles_per_column > collapsed ? triangles_per_column - collapsed : 0U);
+}
+
+template<typename Topology, typename Surface>
+constexpr size_t surface_vertex_count(unsigned int columns, unsigned int rows)
+{
+    if constexpr (std::is_same_v<Topology, BarycentricTopology>) {
+        return surface_triangle_count<Surface>(columns, rows) * 3U;
+    } else if constexpr (std::is_same_v<Topology, TriangleFanTopology>) {
+        return static_cast<size_t>(columns + 1U) * static_cast<size_t>(rows) + 1U;
+    } else {
+        return static_cast<size_t>(columns + 1U) * static_cast<size_t>(rows + 1U);
+    }
+}
+
+template<typename Topology, typename Surface>
+constexpr size_t surface_index_count(unsigned int columns, unsigned int rows)
+{
+    if constexpr (std::is_same_v<Topology, PointTopology>) {
+        return surface_vertex_count<Topology, Surface>(columns, rows);
+    } else if constexpr (std::is_same_v<Topology, TriangleStripTopology>) {
+        return static_cast<size_t>(rows) * 2U * (static_cast<size_t>(columns) + 1U) + (rows > 0U ? 2U * (rows - 1U) : 0U);
+    } else if constexpr (std::is_same_v<Topology, TriangleFanTopology>) {
+        static_assert(Surface::last_row_collapsed, "a fan needs a surface whose last row meets in a point");
+        return static_cast<size_t>(columns) + 2U;
+    } else {
+        static_assert(
+            std::is_same_v<Topology, TriangleTopology> || std::is_same_v<Topology, BarycentricTopology>,
+            "unknown topology"
+        );
+        return surface_triangle_count<Surface>(columns, rows) * 3U;
+    }
+}
+
+namespace detail {
+
+// Calls add_triangle with the grid indices of every triangle of a surface.
+// Cell corners: a and b on a row, c and d below them.
+template<typename Surface, typename Function>
+void for_each_surface_triangle(unsigned int columns, unsigned int rows, Function add_triangle)
+{
+    for (auto row = 0U; row < rows; ++row) {
+        unsigned int row_start{ row * (columns + 1U) };
+        if (row != 0U || !Surface::first_row_collapsed) {
+            for (auto column = 0U; column < columns; ++column) {
+                unsigned int a{ row_start + column };
+                add_triangle(a, a + 1U, a + columns + 1U);
+            }
+        }
+        if (row != rows - 1U || !Surface::last_row_collapsed) {
+            for (auto column = 0U; column < columns; ++column) {
+                unsigned int a{ row_start + column };
+                add_triangle(a + 1U, a + columns + 2U, a + columns + 1U);
+            }
+        }
+    }
+}
+
+}
+
+// Appends one sampled surface to the buffers. Indices are offset by the
+// vertices already there, so several surfaces can share a geometry.
+template<typename Format, typename Topology, typename Surface>
+void append_surface(
+    GeometryData<typename Format::vertex_type>& geometry,
+    const Surface& surface, unsigned int columns, unsigned int rows, const glm::vec4& color
+)
+{
+    auto& [vertices, indices] = geometry;
+    auto first_vertex = static_cast<unsigned int>(vertices.size());
+
+    // A strip continues the strip of the surface before it.
+    size_t join_index_count{ 0 };
+    if constexpr (std::is_same_v<Topology, TriangleStripTopology>) {
+        join_index_count = indices.empty() ? 0U : 2U;
+    } else if constexpr (std::is_same_v<Topology, TriangleFanTopology>) {
+        assert(indices.empty() && rows == 1U);
+    }
+
+    size_t vertex{ vertices.size() }, index{ indices.size() };
+    vertices.resize(vertex + surface_vertex_count<Topology, Surface>(columns, rows));
+    indices.resize(index + join_index_count + surface_index_count<Topology, Surface>(columns, rows));
+
+    if constexpr (std::is_same_v<Topology, BarycentricTopology>) {
+        std::vector<SurfacePoint> points;
+        points.reserve(surface_vertex_count<TriangleTopology, Surface>(columns, rows));
+        for (auto row = 0U; row <= rows; ++row) {
+            float v{ static_cast<float>(row) / static_cast<float>(rows) };
+            for (auto column = 0U; column <= columns; ++column) {
+                float u{ static_cast<float>(column) / static_cast<float>(columns) };
+                points.push_back(surface(u, v));
+            }
+        }
+
+        const glm::vec4 corner_colors[3]{
+            glm::vec4{ 1.0f, 0.0f, 0.0f, color.a },
+            glm::vec4{ 0.0f, 1.0f, 0.0f, color.a },
+            glm::vec4{ 0.0f, 0.0f, 1.0f, color.a }
+        };
+        detail::for_each_surface_triangle<Surface>(columns, rows, [&](unsigned int a, unsigned int b, unsigned int c) {
+            const unsigned int corners[3]{ a, b, c };
+            for (size_t corner = 0; corner < 3; ++corner) {
+                indices[index++] = static_cast<unsigned int>(vertex);
+                vertices[vertex++] = Format::make(points[corners[corner]], corner_colors[corner]);
+            }
+        });
+
+        return;
+    }
+
+    unsigned int sampled_rows{ std::is_same_v<Topology, TriangleFanTopology> ? rows : rows + 1U };
+    for (auto row = 0U; row < sampled_rows; ++row) {
+        float v{ static_cast<float>(row) / static_cast<float>(rows) };
+        for (auto column = 0U; column <= columns; ++column) {
+            float u{ static_cast<float>(column) / static_cast<float>(columns) };
+            vertices[vertex++] = Format::make(surface(u, v), color);
+        }
+    }
+    if constexpr (std::is_same_v<Topology, TriangleFanTopology>) {
+        vertices[vertex++] = Format::make(surface(0.0f, 1.0f), color);
+    }
+
+    if constexpr (std::is_same_v<Topology, PointTopology>) {
+        for (size_t i = 0; i < surface_vertex_count<Topology, Surface>(columns, rows); ++i) {
+            indices[index++] = first_vertex + static_cast<unsigned int>(i);
+        }
+    } else if constexpr (std::is_same_v<Topology, TriangleStripTopology>) {
+        // Starting every column below the row keeps the winding of the
+        // triangle lists; the cells are split along the other diagonal.
+        for (auto row = 0U; row < rows; ++row) {
+            unsigned int row_start{ first_vertex + row * (columns + 1U) };
+            if (join_index_count != 0U || row != 0U) {
+                unsigned int previous{ indices[index - 1U] };
+                indices[index++] = previous;
+                indices[index++] = row_start + columns + 1U;
+            }
+            for (auto column = 0U; column <= columns; ++column) {
+                indices[index++] = row_start + columns + 1U + column;
+                indices[index++] = row_start + column;
+            }
+        }
+    } else if constexpr (std::is_same_v<Topology, TriangleFanTopology>) {
+        indices[index++] = first_vertex + columns + 1U;
+        for (auto column = 0U; column <= columns; ++column) {
+            indices[index++] = first_vertex + column;
+        }
+    } else {
+        detail::for_each_surface_triangle<Surface>(columns, rows, [&](unsigned int a, unsigned int b, unsigned int c) {
+            indices[index++] = first_vertex + a;
+            indices[index++] = first_vertex + b;
+            indices[index++] = first_vertex + c;
+        });
+    }
+}
+
+template<typename Format, typename Topology, typename Surface>
+GeometryData<typename Format::vertex_type> generate_surface(
+    const Surface& surface, unsigned int columns, unsigned int rows, const glm::vec4& color
+)
+{
+    GeometryData<typename Format::vertex_type> geometry;
+    append_surface<Format, Topology>(geometry, surface, columns, rows, color);
+
+    return geometry;
+}
+
+// Copies a mesh generated at compile time by fixed_meshes.h into the vertex
+// layout of an asr version. Nothing is computed besides the conversion.
+template<typename Format, size_t VertexCount, size_t IndexCount>
+GeometryData<typename Format::vertex_type> copy_fixed_mesh(
+    const fixed_meshes::FixedMesh<VertexCount, IndexCount>& mesh, const glm::vec4& color = glm::vec4{ 1.0f }
+)
+{
+    GeometryData<typename Format::vertex_type> geometry;
+    auto& [vertices, indices] = geometry;
+
+    vertices.reserve(VertexCount);
+    for (const auto& vertex : mesh.vertices) {
+        SurfacePoint point{
+            glm::vec3{ vertex.position[0], vertex.position[1], vertex.position[2] },
+            glm::vec3{ vertex.normal[0], vertex.normal[1], vertex.normal[2] },
+            glm::vec2{ vertex.texture_coordinates[0], vertex.texture_coordinates[1] }
+        };
+        vertices.push_back(Format::make(point, color));
+    }
+    indices.assign(mesh.indices.begin(), mesh.indices.end());
+
+    return geometry;
+}
+
+// Edges
+
+// The edges of a triangle list as a line list with every edge once, however
+// many triangles share it. The lines index the vertices of the triangles, so
+// a wireframe is drawn from the same vertex data as the faces.
+inline std::vector<unsigned int> extract_unique_edges(const std::vector<unsigned int>& triangle_indices)
+{
+    std::vector<uint64_t> edges;
+    edges.reserve(triangle_indices.size());
+    for (size_t i = 0; i + 2 < triangle_indices.size(); i += 3) {
+        for (size_t corner = 0; corner < 3; ++corner) {
+            uint64_t a{ triangle_indices[i + corner] }, b{ triangle_indices[i + (corner + 1U) % 3U] };
+            if (a != b) {
+                edges.push_back(a < b ? (a << 32U) | b : (b << 32U) | a);
+            }
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+    std::vector<unsigned int> line_indices;
+    line_indices.reserve(edges.size() * 2U);
+    for (auto edge : edges) {
+        line_indices.push_back(static_cast<unsigned int>(edge >> 32U));
+        line_indices.push_back(static_cast<unsigned int>(edge & 0xFFFFFFFFU));
+    }
+
+    return line_indices;
+}
+
+// Remaps every index to the first vertex at the same position, for meshes
+// that repeat their vertices per triangle. Edges extracted from the result
+// are shared by the triangles on both of their sides. Throws
+// std::out_of_range for an index past the end of the vertices.
+template<typename Vertex, typename Position>
+std::vector<unsigned int> weld_indices(
+    const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, Position position
+)
+{
+    std::map<std::tuple<float, float, float>, unsigned int> first_vertices;
+    std::vector<unsigned int> remap(vertices.size());
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        glm::vec3 point{ position(vertices[i]) };
+        remap[i] = first_vertices.emplace(std::make_tuple(point.x, point.y, point.z), static_cast<unsigned int>(i)).first->second;
+    }
+
+    std::vector<unsigned int> welded_indices;
+    welded_indices.reserve(indices.size());
+    for (auto index : indices) {
+        if (index >= remap.size()) {
+            throw std::out_of_range{ "weld_indices: index past the end of the vertices" };
+        }
+        welded_indices.push_back(remap[index]);
+    }
+
+    return welded_indices;
+}
+
+// Shapes
+
+// A rectangle in the XY plane facing +Z.
+template<typename Format, typename Topology>
+GeometryData<typename Format::vertex_type> generate_rectangle(
+    float width, float height, unsigned int width_segments_count, unsigned int height_segments_count,
+    const glm::vec4& color = glm::vec4{ 1.0f }
+)
+{
+    Patch patch{ glm::vec3{ 0.0f }, glm::vec3{ width, 0.0f, 0.0f }, glm::vec3{ 0.0f, height, 0.0f } };
+
+    return generate_surface<Format, Topology>(patch, width_segments_count, height_segments_count, color);
+}
+
+// A disc in the XY plane facing +Z.
+template<typename Format, typename Topology>
+GeometryData<typename Format::vertex_type> generate_circle(
+    float radius, unsigned int segment_count, const glm::vec4& color = glm::vec4{ 1.0f }
+)
+{
+    Disc disc{ glm::vec3{ 0.0f }, glm::vec3{ 1.0f, 0.0f, 0.0f }, glm::vec3{ 0.0f, 1.0f, 0.0f }, radius };
+
+    return generate_surface<Format, Topology>(disc, segment_count, 1U, color);
+}
+
+template<typename Format, typename Topology>
+GeometryData<typename Format::vertex_type> generate_sphere(
+    float radius, unsigned int width_segments_count, unsigned int height_segments_count,
+    const glm::vec4& color = glm::vec4{ 1.0f }
+)
+{
+    return generate_surface<Format, Topology>(Sphere{ radius }, width_segments_count, height_segments_count, color);
+}
+
+template<typename Format, typename Topology>
+GeometryData<typename Format::vertex_type> generate_box(
+    float width, float height, float depth,
+    unsigned int width_segments_count, unsigned int height_segments_count, unsigned int depth_segments_count,
+    const glm::vec4& color = glm::vec4{ 1.0f }
+)
+{
+    glm::vec3 x{ width, 0.0f, 0.0f }, y{ 0.0f, height, 0.0f }, z{ 0.0f, 0.0f, depth };
+    glm::vec3 half_x{ x * 0.5f }, half_y{ y * 0.5f }, half_z{ z * 0.5f };
+
+    struct Side {
+        Patch patch;
+        unsigned int columns, rows;
+    };
+    const Side sides[]{
+        { Patch{ half_z, x, y }, width_segments_count, height_segments_count },
+        { Patch{ -half_z, -x, y }, width_segments_count, height_segments_count },
+        { Patch{ half_x, -z, y }, depth_segments_count, height_segments_count },
+        { Patch{ -half_x, z, y }, depth_segments_count, height_segments_count },
+        { Patch{ half_y, x, -z }, width_segments_count, depth_segments_count },
+        { Patch{ -half_y, x, z }, width_segments_count, depth_segments_count }
+    };
+
+    size_t vertex_count{ 0 }, index_count{ 0 };
+    for (const auto& side : sides) {
+        vertex_count += surface_vertex_count<Topology, Patch>(side.columns, side.rows);
+        index_count += surface_index_count<Topology, Patch>(side.columns, side.rows);
+    }
+
+    GeometryData<typename Format::vertex_type> geometry;
+    geometry.first.reserve(vertex_count);
+    geometry.second.reserve(index_count);
+    for (const auto& side : sides) {
+        append_surface<Format, Topology>(geometry, side.patch, side.columns, side.rows, color);
+    }
+
+    return geometry;
+}
+
+// A closed cylinder around the Y axis.
+template<typename Format, typename Topology>
+GeometryData<typename Format::vertex_type> generate_cylinder(
+    float radius, float height, unsigned int radial_segments_count, unsigned int height_segments_count,
+    const glm::vec4& color = glm::vec4{ 1.0f }
+)
+{
+    CylinderSide side{ radius, height };
+    Disc top{ glm::vec3{ 0.0f, 0.5f * height, 0.0f }, glm::vec3{ 0.0f, 0.0f, 1.0f }, glm::vec3{ 1.0f, 0.0f, 0.0f }, radius };
+    Disc bottom{ glm::vec3{ 0.0f, -0.5f * height, 0.0f }, glm::vec3{ 1.0f, 0.0f, 0.0f }, glm::vec3{ 0.0f, 0.0f, 1.0f }, radius };
+
+    GeometryData<typename Format::vertex_type> geometry;
+    geometry.first.reserve(
+        surface_vertex_count<Topology, CylinderSide>(radial_segments_count, height_segments_count) +
+        2U * surface_vertex_count<Topology, Disc>(radial_segments_count, 1U)
+    );
+    geometry.second.reserve(
+        surface_index_count<Topology, CylinderSide>(radial_segments_count, height_segments_count) +
+        2U * surface_index_count<Topology, Disc>(radial_segments_count, 1U)
+    );
+    append_surface<Format, Topology>(geometry, side, radial_segments_count, height_segments_count, color);
+    append_surface<Format, Topology>(geometry, top, radial_segments_count, 1U, color);
+    append_surface<Format, Topology>(geometry, bottom, radial_segments_count, 1U, color);
+
+    return geometry;
+}
+
+// A closed cone around the Y axis with its apex at the top.
+template<typename Format, typename Topology>
+GeometryData<typename Format::vertex_type> generate_cone(
+    float radius, float height, unsigned int radial_segments_count, unsigned int height_segments_count,
+    const glm::vec4& color = glm::vec4{ 1.0f }
+)
+{
+    ConeSide side{ radius, height };
+    Disc bottom{ glm::vec3{ 0.0f, -0.5f * height, 0.0f }, glm::vec3{ 1.0f, 0.0f, 0.0f }, glm::vec3{ 0.0f, 0.0f, 1.0f }, radius };
+
+    GeometryData<typename Format::vertex_type> geometry;
+    geometry.first.reserve(
+        surface_vertex_count<Topology, ConeSide>(radial_segments_count, height_segments_count) +
+        surface_vertex_count<Topology, Disc>(radial_segments_count, 1U)
+    );
+    geometry.second.reserve(
+        surface_index_count<Topology, ConeSide>(radial_segments_count, height_segments_count) +
+        surface_index_count<Topology, Disc>(radial_segments_count, 1U)
+    );
+    append_surface<Format, Topology>(geometry, side, radial_segments_count, height_segments_count, color);
+    append_surface<Format, Topology>(geometry, bottom, radial_segments_count, 1U, color);
+
+    return geometry;
+}
+
+template<typename Format, typename Topology>
+GeometryData<typename Format::vertex_type> generate_torus(
+    float radius, float tube_radius, unsigned int radial_segments_count, unsigned int tube_segments_count,
+    const glm::vec4& color = glm::vec4{ 1.0f }
+)
+{
+    return generate_surface<Format, Topology>(Torus{ radius, tube_radius }, radial_segments_count, tube_segments_count, color);
+}
+
+// A capsule around the Y axis; height is the length of its cylinder.
+template<typename Format, typename Topology>
+GeometryData<typename Format::vertex_type> generate_capsule(
+    float radius, float height, unsigned int radial_segments_count, unsigned int height_segments_count,
+    const glm::vec4& color = glm::vec4{ 1.0f }
+)
+{
+    return generate_surface<Format, Topology>(Capsule{ radius, height }, radial_segments_count, height_segments_count, color);
+}
+
+}
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef TRANSFORMS_H
+#define TRANSFORMS_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+// Model matrices composed the way asr composes them on its matrix stack, for
+// code that transforms geometry or uploads matrices itself. Every lab and the
+// game build their matrices here so they agree with translate_matrix,
+// rotate_matrix and scale_matrix and with each other.
+
+namespace transforms {
+
+// rotate_matrix multiplies by the rotations about Z, Y and X in that order,
+// so a vertex is rotated about X first.
+inline glm::mat4 make_model_matrix(
+    const glm::vec3& position, const glm::vec3& rotation, const glm::vec3& scale = glm::vec3{ 1.0f }
+)
+{
+    glm::mat4 matrix = glm::translate(glm::mat4{ 1.0f }, position);
+    matrix = glm::rotate(matrix, rotation.z, glm::vec3{ 0.0f, 0.0f, 1.0f });
+    matrix = glm::rotate(matrix, rotation.y, glm::vec3{ 0.0f, 1.0f, 0.0f });
+    matrix = glm::rotate(matrix, rotation.x, glm::vec3{ 1.0f, 0.0f, 0.0f });
+
+    return glm::scale(matrix, scale);
+}
+
+}
+
+#endif
@@ -32,29 +32,28 @@ static const std::string Fragment_Shader_Source = R"(
     }
 )";
 
+// A triangle fan: the center, then the rim with its first vertex repeated at
+// the end to close it, segment_count + 2 vertices instead of three per slice.
 std::vector<float> generate_circle_geometry_data(
     float radius,
     unsigned int segment_count
 )
 {
     std::vector<float> vertices;
+    vertices.reserve((segment_count + 2) * 7);
+
+    vertices.insert(vertices.end(), { 0.0f, 0.0f, 0.0f });
+    vertices.insert(vertices.end(), { 1.0f, 1.0f, 1.0f, 1.0f });
 
     float angle = 0.0f;
     float angle_delta = static_cast<float>(M_PI)*2.0f/segment_count;
 
-    for (unsigned int i = 0; i < segment_count; i++)
+    for (unsigned int i = 0; i <= segment_count; i++)
     {
-        vertices.insert(vertices.end(), { 0.0f, 0.0f, 0.0f });
-        vertices.insert(vertices.end(), { 1.0f, 1.0f, 1.0f, 1.0f });
-
-
-        vertices.insert(vertices.end(), { cosf(angle) * radius , sinf(angle) * radius, 0.0f });
+        vertices.insert(vertices.end(), { cosf(angle) * radius, sinf(angle) * radius, 0.0f });
         vertices.insert(vertices.end(), { 1.0f, 1.0f, 1.0f, 1.0f });
 
         angle = angle + angle_delta;
-
-        vertices.insert(vertices.end(), { cosf(angle) * radius, sinf(angle) * radius, 0.0f });
-        vertices.insert(vertices.end(), { 1.0f, 1.0f, 1.0f, 1.0f });
     }
 
     return vertices;
@@ -69,7 +68,7 @@ int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
 
     auto geometry = generate_circle_geometry_data(0.5f, 60);
     size_t geometry_vertex_count{ geometry.size()/7 };
-    create_geometry(GeometryType::Triangles, &geometry[0], geometry_vertex_count);
+    create_geometry(GeometryType::TriangleFan, &geometry[0], geometry_vertex_count);
     
     prepare_for_rendering();
     bool should_stop = false;
@@ -32,6 +32,11 @@ static const std::string Fragment_Shader_Source = R"(
     }
 )";
 
+// One triangle strip down the rows of cells, each row zigzagging from left
+// to right. The rows are joined by repeating the last vertex of a row and
+// the first of the next, which adds degenerate triangles that are never
+// rasterized: 2 * (width_segments_count + 2) vertices per row instead of six
+// per cell.
 std::vector<float> generate_rectangle_geometry_data(
     float width,
     float height,
@@ -40,28 +45,28 @@ std::vector<float> generate_rectangle_geometry_data(
 )
 {
     std::vector<float> vertices;
+    vertices.reserve(height_segments_count * (width_segments_count + 2) * 2 * 7);
 
     float h = (height * height_segments_count) / 2.0f;
     float w = (width * width_segments_count) / 2.0f;
     float r = 1.0f, g = 1.0f, b = 1.0f, a = 1.0f;
 
-    for (unsigned int i = 0; i < width_segments_count; i++)
+    for (unsigned int j = 0; j < height_segments_count; j++)
     {
-        for (unsigned int j = 0; j < height_segments_count; j++)
-        {
-            float x { -w + i * width };
-            float y { h - j * height };
+        float y { h - j * height };
 
-            vertices.insert(vertices.end(), { x, y, 0.0f });
+        if (j != 0) {
+            vertices.insert(vertices.end(), { w, y, 0.0f });
             vertices.insert(vertices.end(), { r, g, b, a });
-            vertices.insert(vertices.end(), { x + width, y, 0.0f });
-            vertices.insert(vertices.end(), { r, g, b, a });
-            vertices.insert(vertices.end(), { x, y - height, 0.0f });
+            vertices.insert(vertices.end(), { -w, y, 0.0f });
             vertices.insert(vertices.end(), { r, g, b, a });
+        }
 
-            vertices.insert(vertices.end(), { x + width, y - height, 0.0f });
-            vertices.insert(vertices.end(), { r, g, b, a });
-            vertices.insert(vertices.end(), { x + width,  y, 0.0f });
+        for (unsigned int i = 0; i <= width_segments_count; i++)
+        {
+            float x { -w + i * width };
+
+            vertices.insert(vertices.end(), { x, y, 0.0f });
             vertices.insert(vertices.end(), { r, g, b, a });
             vertices.insert(vertices.end(), { x, y - height, 0.0f });
             vertices.insert(vertices.end(), { r, g, b, a });
@@ -81,7 +86,7 @@ int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
     auto geometry = generate_rectangle_geometry_data(0.2f, 0.2f, 5, 5);
 
     size_t geometry_vertex_count{ geometry.size() / 7};
-    create_geometry(GeometryType::Triangles, &geometry[0], geometry_vertex_count);
+    create_geometry(GeometryType::TriangleStrip, &geometry[0], geometry_vertex_count);
     
     prepare_for_rendering();
     bool should_stop = false;
@@ -0,0 +1,127 @@
+#ifndef PROGRAM_INPUTS_H
+#define PROGRAM_INPUTS_H
+
+#include "asr.h"
+
+#include <cstddef>
+#include <optional>
+
+// Draws geometry that asr 1.1 does not own (asr only draws its immutable
+// geometry) with the shader created by create_shader. asr binds that one
+// program when it is created and keeps it for the lifetime of the window, so
+// it and the locations of its inputs are looked up on the first of these
+// draws and no GL state is queried per draw. The attributes are those of
+// asr::Vertex.
+class ProgramInputs {
+public:
+    // Draws index_count indices starting at the byte offset into the index
+    // buffer, with the vertices starting at the byte offset into the vertex
+    // buffer. A color replaces the vertex colors.
+    void draw(
+        GLuint vertex_buffer, size_t vertex_offset, GLuint index_buffer, size_t index_offset,
+        asr::GeometryType type, size_t index_count,
+        const glm::mat4& model_view_projection_matrix, const std::optional<glm::vec4>& color = std::nullopt
+    )
+    {
+        if (_program == 0) {
+            _look_up();
+        }
+        glUseProgram(_program);
+
+        glUniformMatrix4fv(_matrix_location, 1, GL_FALSE, &model_view_projection_matrix[0][0]);
+
+        glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+        if (_position_location >= 0) {
+            glEnableVertexAttribArray(static_cast<GLuint>(_position_location));
+            glVertexAttribPointer(
+                static_cast<GLuint>(_position_location), 3, GL_FLOAT, GL_FALSE, sizeof(asr::Vertex),
+                reinterpret_cast<const GLvoid*>(vertex_offset)
+            );
+        }
+        // A disabled attribute array reads the current constant value, which
+        // replaces the vertex colors without another shader.
+        if (_color_location >= 0) {
+            if (color) {
+                glVertexAttrib4fv(static_cast<GLuint>(_color_location), &(*color)[0]);
+            } else {
+                glEnableVertexAttribArray(static_cast<GLuint>(_color_location));
+                glVertexAttribPointer(
+                    static_cast<GLuint>(_color_location), 4, GL_FLOAT, GL_FALSE, sizeof(asr::Vertex),
+                    reinterpret_cast<const GLvoid*>(vertex_offset + VERTEX_COLOR_OFFSET)
+                );
+            }
+        }
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer);
+        glDrawElements(
+            _primitive_mode(type), static_cast<GLsizei>(index_count), GL_UNSIGNED_INT,
+            reinterpret_cast<const GLvoid*>(index_offset)
+        );
+
+        if (_position_location >= 0) {
+            glDisableVertexAttribArray(static_cast<GLuint>(_position_location));
+        }
+        if (_color_location >= 0) {
+            glDisableVertexAttribArray(static_cast<GLuint>(_color_location));
+        }
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+private:
+    typedef asr::Indices::value_type index_type;
+    static_assert(sizeof(index_type) == sizeof(GLuint), "indices are drawn as GL_UNSIGNED_INT");
+
+    // asr::Vertex starts with the position (x, y, z) followed by the color.
+    static const size_t VERTEX_COLOR_OFFSET{ 3 * sizeof(float) };
+
+    GLuint _program{ 0 };
+    GLint _matrix_location{ -1 }, _position_location{ -1 }, _color_location{ -1 };
+
+    void _look_up()
+    {
+        GLint program{ 0 };
+        glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+        _program = static_cast<GLuint>(program);
+
+        _matrix_location = glGetUniformLocation(_program, "model_view_projection_matrix");
+        _position_location = glGetAttribLocation(_program, "position");
+        _color_location = glGetAttribLocation(_program, "color");
+    }
+
+    [[nodiscard]] static GLenum _primitive_mode(asr::GeometryType type)
+    {
+        switch (type) {
+            case asr::GeometryType::Lines:
+                return GL_LINES;
+            case asr::GeometryType::Points:
+                return GL_POINTS;
+            case asr::GeometryType::LineStrip:
+                return GL_LINE_STRIP;
+            case asr::GeometryType::TriangleStrip:
+                return GL_TRIANGLE_STRIP;
+            case asr::GeometryType::TriangleFan:
+                return GL_TRIANGLE_FAN;
+            default:
+                return GL_TRIANGLES;
+        }
+    }
+};
+
+// Loads the perspective projection into asr and returns the same matrix for
+// the geometry drawn outside of it. asr takes the aspect ratio from the
+// window, so it is read from the viewport here. Called every frame, the two
+// stay the same when the window is resized.
+inline glm::mat4 load_perspective_projection(float field_of_view, float near_plane, float far_plane)
+{
+    asr::set_matrix_mode(asr::MatrixMode::Projection);
+    asr::load_perspective_projection_matrix(field_of_view, near_plane, far_plane);
+
+    GLint viewport[4]{ 0, 0, 1, 1 };
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    float aspect_ratio{ static_cast<float>(viewport[2]) / static_cast<float>(viewport[3] > 0 ? viewport[3] : 1) };
+
+    return glm::perspective(field_of_view, aspect_ratio, near_plane, far_plane);
+}
+
+#endif
@@ -0,0 +1,103 @@
+#ifndef SHARED_VERTEX_GEOMETRY_H
+#define SHARED_VERTEX_GEOMETRY_H
+
+#include "asr.h"
+#include "program_inputs.h"
+
+#include <cstddef>
+#include <optional>
+#include <stdexcept>
+
+// One vertex buffer drawn through several index ranges, for example the
+// faces, the edges and the vertices of a mesh. Every view has its own
+// topology and may replace the vertex colors with a constant color, so the
+// vertices are uploaded once however many ways they are drawn.
+//
+// asr geometry owns one vertex and one index buffer each, so this is done
+// with GL directly: the views share one index buffer and are drawn through
+// ProgramInputs with the shader of asr.
+class SharedVertexGeometry {
+public:
+    struct View {
+        asr::GeometryType type;
+        size_t first_index, index_count;
+        std::optional<glm::vec4> color;
+    };
+
+    explicit SharedVertexGeometry(const asr::Vertices& vertices) :
+        _vertex_count{ vertices.size() }
+    {
+        glGenBuffers(1, &_vertex_buffer);
+        glBindBuffer(GL_ARRAY_BUFFER, _vertex_buffer);
+        glBufferData(
+            GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(vertices.size() * sizeof(asr::Vertex)), vertices.data(), GL_STATIC_DRAW
+        );
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        glGenBuffers(1, &_index_buffer);
+    }
+
+    SharedVertexGeometry(const SharedVertexGeometry&) = delete;
+    SharedVertexGeometry& operator=(const SharedVertexGeometry&) = delete;
+
+    // Like asr geometry, the buffers are released explicitly while the window
+    // and its context still exist.
+    void destroy()
+    {
+        glDeleteBuffers(1, &_index_buffer);
+        glDeleteBuffers(1, &_vertex_buffer);
+        _index_buffer = _vertex_buffer = 0;
+    }
+
+    // Indices point into the shared vertices; an index past them throws
+    // std::out_of_range. Without a color the view is drawn with the vertex
+    // colors. The index buffer is uploaded again before the next draw, so
+    // views are best added before the first frame.
+    [[nodiscard]] View add_view(
+        asr::GeometryType type, const asr::Indices& indices, std::optional<glm::vec4> color = std::nullopt
+    )
+    {
+        for (auto index : indices) {
+            if (index >= _vertex_count) {
+                throw std::out_of_range{ "SharedVertexGeometry: index past the end of the vertices" };
+            }
+        }
+        View view{ type, _indices.size(), indices.size(), color };
+        _indices.insert(_indices.end(), indices.begin(), indices.end());
+        _indices_changed = true;
+
+        return view;
+    }
+
+    void render(const View& view, const glm::mat4& model_view_projection_matrix)
+    {
+        if (_indices_changed) {
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _index_buffer);
+            glBufferData(
+                GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(_indices.size() * sizeof(index_type)),
+                _indices.data(), GL_STATIC_DRAW
+            );
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+            _indices_changed = false;
+        }
+
+        _program_inputs.draw(
+            _vertex_buffer, 0, _index_buffer, view.first_index * sizeof(index_type),
+            view.type, view.index_count, model_view_projection_matrix, view.color
+        );
+    }
+
+private:
+    typedef asr::Indices::value_type index_type;
+    static_assert(sizeof(index_type) == sizeof(GLuint), "indices are drawn as GL_UNSIGNED_INT");
+
+    size_t _vertex_count;
+    asr::Indices _indices;
+    bool _indices_changed{ false };
+
+    GLuint _vertex_buffer{ 0 }, _index_buffer{ 0 };
+
+    ProgramInputs _program_inputs;
+};
+
+#endif
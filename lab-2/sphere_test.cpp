@@ -1,7 +1,12 @@
 #include "asr.h"
+#include "shared_vertex_geometry.h"
+#include "../common/surface_generators.h"
+#include "../common/transforms.h"
 
+#include <numeric>
 #include <string>
 #include <utility>
+#include <vector>
 
 static const std::string Vertex_Shader_Source{ R"( // NOLINT(cert-err58-cpp)
     #version 110
@@ -33,108 +38,71 @@ static const std::string Fragment_Shader_Source{ R"( // NOLINT(cert-err58-cpp)
     }
 )" };
 
-static asr::GeometryPair generate_sphere_geometry_data(
-    asr::GeometryType geometryType,
-    float radius,
-    unsigned int width_segments_count,
-    unsigned int height_segments_count,
-    glm::vec4 color = glm::vec4{ 1.0f, 1.0f, 1.0f, 1.0f }
-)
-{
-    assert(
-        geometryType == asr::GeometryType::Triangles ||
-        geometryType == asr::GeometryType::Lines ||
-        geometryType == asr::GeometryType::Points
-    );
-
-    asr::Vertices vertices;
-    asr::Indices indices;
-
-    for (auto i = 0U; i <= height_segments_count; ++i) {
-        float v { static_cast<float>(i) / static_cast<float>(height_segments_count) };
-
-        float phi {v * asr::pi};
-            
-        for (auto j = 0U; j <= width_segments_count; ++j) {
-            float u{ static_cast<float>(j) / static_cast<float>(width_segments_count) };
-
-            float theta{ u * asr::two_pi };
-
-            float cos_phi{ std::cosf(phi) };
-            float sin_phi{ std::sinf(phi) };
-            float cos_theta{ std::cosf(theta) };
-            float sin_theta{ std::sinf(theta) };
+// Draws the faces and their edges in one pass. The vertex colors of
+// BarycentricTopology are the barycentric coordinates of every fragment; a
+// fragment within about a pixel and a half of an edge gets the edge color.
+static const std::string Barycentric_Wireframe_Fragment_Shader_Source{ R"( // NOLINT(cert-err58-cpp)
+    #version 110
 
-            float x{ radius * cos_theta * sin_phi };
-            float y{ radius * cos_phi };
-            float z{ radius * sin_phi * sin_theta };
+    const vec4 face_color = vec4(1.0, 1.0, 1.0, 1.0);
+    const vec4 edge_color = vec4(1.0, 0.7, 0.7, 1.0);
 
-            vertices.push_back(asr::Vertex { x, y, z, color.r, color.g, color.b, color.a });
+    varying vec4 fragment_color;
 
-            if (geometryType == asr::GeometryType::Points)
-            {
-                indices.push_back(vertices.size() - 1);
-            }
-        }
-    }
+    void main()
+    {
+        vec3 barycentric = fragment_color.rgb;
+        vec3 distance_to_edge = smoothstep(vec3(0.0), fwidth(barycentric) * 1.5, barycentric);
+        float edge = 1.0 - min(min(distance_to_edge.x, distance_to_edge.y), distance_to_edge.z);
 
-    if (geometryType == asr::GeometryType::Lines || geometryType == asr::GeometryType::Triangles) {
-        for (auto rows = 0U; rows < height_segments_count; ++rows) {
-            for (auto columns = 0U; columns < width_segments_count; ++columns) {
-                unsigned int index_a{ rows * (width_segments_count + 1) + columns };
-                unsigned int index_b{ index_a + 1 };
-                unsigned int index_c{ index_a + (width_segments_count + 1) };
-                unsigned int index_d{ index_c + 1 };
-
-                if (geometryType == asr::GeometryType::Lines) {
-                    indices.insert(indices.end(), { index_a, index_b, index_b, index_c, index_c, index_a });
-                    indices.insert(indices.end(), {index_b, index_d, index_d, index_c, index_c, index_b });
-                } else {
-                    if (rows != 0) {
-                        indices.insert(indices.end(), { index_a, index_b, index_c });
-                    } if (rows != height_segments_count-1)
-                    {
-                        indices.insert(indices.end(), { index_b, index_d, index_c });
-                    }
-                }
-            }
-        }
+        gl_FragColor = mix(face_color, edge_color, edge);
     }
+)" };
 
-    return std::make_pair(vertices, indices);
-}
+typedef surface_generators::PositionColor<asr::Vertex> vertex_format;
 
-int main([[maybe_unused]] int argc, [[maybe_unused]] char** argv) {
+int main(int argc, char** argv) {
     using namespace asr;
 
+    // With --barycentric-wireframe the edges are shaded into the faces
+    // instead of being drawn as a separate line geometry.
+    bool barycentric_wireframe{ argc > 1 && std::string{ argv[1] } == "--barycentric-wireframe" };
+
     create_window(500, 500, "Sphere Test on ASR Version 1.1");
-    create_shader(Vertex_Shader_Source, Fragment_Shader_Source);
+    create_shader(
+        Vertex_Shader_Source,
+        barycentric_wireframe ? Barycentric_Wireframe_Fragment_Shader_Source : Fragment_Shader_Source
+    );
 
     float radius{0.5f};
     unsigned int width_segments{ 20 }, height_segments{ 20 };
 
     auto [triangle_vertices, triangle_indices] =
-        generate_sphere_geometry_data(
-            Triangles, radius, width_segments, height_segments
-        );
-    auto triangles =
-        create_geometry(
-            Triangles, triangle_vertices, triangle_indices
-        );
-
-    glm::vec4 edge_color{ 1.0f, 0.7f, 0.7f, 1.0f };
-    auto [edge_vertices, edge_indices] =
-        generate_sphere_geometry_data(
-            Lines, radius * 1.005f, width_segments, height_segments, edge_color
-        );
-    auto lines = create_geometry(Lines, edge_vertices, edge_indices);
-
-    glm::vec4 vertex_color{ 1.0f, 0.0f, 0.0f, 1.0f };
-    auto [vertices, vertex_indices] =
-        generate_sphere_geometry_data(
-            Points, radius * 1.01f, width_segments, height_segments, vertex_color
-        );
-    auto points = create_geometry(Points, vertices, vertex_indices);
+        barycentric_wireframe ?
+            surface_generators::generate_sphere<vertex_format, surface_generators::BarycentricTopology>(
+                radius, width_segments, height_segments
+            ) :
+            surface_generators::generate_sphere<vertex_format, surface_generators::TriangleTopology>(
+                radius, width_segments, height_segments
+            );
+
+    // The faces, the edges and the vertices are three views of one vertex
+    // buffer. The edges are every edge of the faces once, and the views
+    // differ only in their color. The faces are pushed back by the polygon
+    // offset below, so the edges and the points in front of them need no
+    // larger radius. The barycentric wireframe draws only the faces.
+    SharedVertexGeometry sphere{ triangle_vertices };
+    auto triangles = sphere.add_view(Triangles, triangle_indices);
+    std::vector<SharedVertexGeometry::View> overlays;
+    if (!barycentric_wireframe) {
+        glm::vec4 edge_color{ 1.0f, 0.7f, 0.7f, 1.0f };
+        overlays.push_back(sphere.add_view(Lines, surface_generators::extract_unique_edges(triangle_indices), edge_color));
+
+        Indices vertex_indices(triangle_vertices.size());
+        std::iota(vertex_indices.begin(), vertex_indices.end(), 0U);
+        glm::vec4 vertex_color{ 1.0f, 0.0f, 0.0f, 1.0f };
+        overlays.push_back(sphere.add_view(Points, vertex_indices, vertex_color));
+    }
 
     glm::vec3 sphere_position{0.0f, 0.0f, 0.0f};
     glm::vec3 sphere_rotation{0.0f, 0.01f, 0.0f};
@@ -145,6 +113,9 @@ int main([[maybe_unused]] int argc, [[maybe_unused]] char** argv) {
     enable_face_culling();
     enable_depth_test();
     set_line_width(3);
+    glEnable(GL_POLYGON_OFFSET_FILL);
+    glPolygonOffset(1.0f, 1.0f);
+    glDepthFunc(GL_LEQUAL);
 
     static const float CAMERA_SPEED{ 0.1f };
     static const float CAMERA_ROT_SPEED{ 0.01f };
@@ -175,9 +146,6 @@ int main([[maybe_unused]] int argc, [[maybe_unused]] char** argv) {
         }
     });
 
-    set_matrix_mode(MatrixMode::Projection);
-    load_perspective_projection_matrix(CAMERA_FOV, CAMERA_NEAR_PLANE, CAMERA_FAR_PLANE);
-
     bool should_stop{ false };
 
     while (!should_stop) {
@@ -185,32 +153,27 @@ int main([[maybe_unused]] int argc, [[maybe_unused]] char** argv) {
 
         prepare_to_render_frame();
 
+        glm::mat4 projection_matrix{ load_perspective_projection(CAMERA_FOV, CAMERA_NEAR_PLANE, CAMERA_FAR_PLANE) };
+
         set_matrix_mode(MatrixMode::View);
         load_identity_matrix();
         translate_matrix(camera_position);
         rotate_matrix(camera_rotation);
 
-        set_matrix_mode(MatrixMode::Model);
-        load_identity_matrix();
-        translate_matrix(sphere_position);
-        rotate_matrix(sphere_rotation);
-        scale_matrix(sphere_scale);
-
-        set_geometry_current(&triangles);
-        render_current_geometry();
-
-        set_geometry_current(&lines);
-        render_current_geometry();
+        // asr does not draw the shared geometry, so the model matrix is built
+        // here and the views get the whole transformation at once.
+        glm::mat4 model_matrix{ transforms::make_model_matrix(sphere_position, sphere_rotation, sphere_scale) };
+        glm::mat4 model_view_projection_matrix{ projection_matrix * glm::inverse(get_view_matrix()) * model_matrix };
 
-        set_geometry_current(&points);
-        render_current_geometry();
+        sphere.render(triangles, model_view_projection_matrix);
+        for (const auto& overlay : overlays) {
+            sphere.render(overlay, model_view_projection_matrix);
+        }
 
         finish_frame_rendering();
     }
 
-    destroy_geometry(triangles);
-    destroy_geometry(lines);
-    destroy_geometry(points);
+    sphere.destroy();
 
     destroy_shader();
     destroy_window();
@@ -1,4 +1,6 @@
 #include "asr.h"
+#include "shared_vertex_geometry.h"
+#include "../common/surface_generators.h"
 
 #include <string>
 #include <utility>
@@ -44,7 +46,6 @@ static asr::GeometryPair generate_triangle_geometry_data(
 {
     assert(
         geometryType == asr::GeometryType::Triangles ||
-        geometryType == asr::GeometryType::Lines ||
         geometryType == asr::GeometryType::Points
     );
 
@@ -94,18 +95,14 @@ static asr::GeometryPair generate_triangle_geometry_data(
         }
     }
 
-    if (geometryType == asr::GeometryType::Lines || geometryType == asr::GeometryType::Triangles) {
-        for (auto j = 0U; j <= height_segments_count * width_segments_count*3; j+=3) {
+    if (geometryType == asr::GeometryType::Triangles) {
+        for (auto j = 0U; j + 2 < vertices.size(); j+=3) {
 
             unsigned int index_a{ j };
             unsigned int index_b{ index_a + 1 };
             unsigned int index_c{ index_a + 2 };
 
-            if (geometryType == asr::GeometryType::Lines) {
-                    indices.insert(indices.end(), { index_a, index_b, index_b, index_c, index_c, index_a });
-            } else {
-                    indices.insert(indices.end(), { index_a, index_b, index_c });
-            }
+            indices.insert(indices.end(), { index_a, index_b, index_c });
         }
     }
 
@@ -126,31 +123,45 @@ int main([[maybe_unused]] int argc, [[maybe_unused]] char** argv)
         generate_triangle_geometry_data(
             Triangles, width, height, width_segments, height_segments
         );
-    auto triangles =
-        create_geometry(
-            Triangles, triangle_vertices, triangle_indices
-        );
+
+    // The faces, the edges and the vertices are three views of the triangle
+    // vertices, differing only in their color. Every triangle has vertices of
+    // its own, so the corners are welded by position before the edges are
+    // extracted, and an edge between two triangles is drawn once. The
+    // generator lays the vertices out the same way for points, so their
+    // indices apply as they are. The faces are pushed back by the polygon
+    // offset below instead of the edges and points being moved toward the
+    // viewer.
+    SharedVertexGeometry triangle{ triangle_vertices };
+    auto triangles = triangle.add_view(Triangles, triangle_indices);
 
     glm::vec4 edge_color{ 1.0f, 0.7f, 0.7f, 1.0f };
-    auto [edge_vertices, edge_indices] =
-        generate_triangle_geometry_data(
-            Lines, width, height, width_segments, height_segments, edge_color
-        );
-    for (auto& vertex : edge_vertices) { vertex.z -= 0.01f; }
-    auto lines = create_geometry(Lines, edge_vertices, edge_indices);
+    auto edge_indices{
+        surface_generators::extract_unique_edges(
+            surface_generators::weld_indices(triangle_vertices, triangle_indices, [](const Vertex& vertex) {
+                return glm::vec3{ vertex.x, vertex.y, vertex.z };
+            })
+        )
+    };
+    auto lines = triangle.add_view(Lines, edge_indices, edge_color);
 
     glm::vec4 vertex_color{ 1.0f, 0.0f, 0.0f, 1.0f };
-    auto [vertices, vertex_indices] =
+    auto vertex_indices =
         generate_triangle_geometry_data(
-            Points, width, height, width_segments, height_segments, vertex_color
-        );
-    for (auto& vertex : vertices) { vertex.z -= 0.02f; }
-    auto points = create_geometry(Points, vertices, vertex_indices);
+            Points, width, height, width_segments, height_segments
+        ).second;
+    auto points = triangle.add_view(Points, vertex_indices, vertex_color);
 
     prepare_for_rendering();
     enable_face_culling();
     enable_depth_test();
     set_line_width(2);
+    glEnable(GL_POLYGON_OFFSET_FILL);
+    glPolygonOffset(1.0f, 1.0f);
+    glDepthFunc(GL_LEQUAL);
+
+    // Nothing in this test is transformed.
+    glm::mat4 model_view_projection_matrix{ 1.0f };
 
     bool should_stop{ false };
     while (!should_stop) {
@@ -158,21 +169,14 @@ int main([[maybe_unused]] int argc, [[maybe_unused]] char** argv)
 
         prepare_to_render_frame();
 
-        set_geometry_current(&triangles);
-        render_current_geometry();
-
-        set_geometry_current(&lines);
-        render_current_geometry();
-
-        set_geometry_current(&points);
-        render_current_geometry();
+        triangle.render(triangles, model_view_projection_matrix);
+        triangle.render(lines, model_view_projection_matrix);
+        triangle.render(points, model_view_projection_matrix);
 
         finish_frame_rendering();
     }
 
-    destroy_geometry(triangles);
-    destroy_geometry(lines);
-    destroy_geometry(points);
+    triangle.destroy();
 
     destroy_shader();
     destroy_window();
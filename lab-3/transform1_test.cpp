@@ -1,4 +1,5 @@
 #include "asr.h"
+#include "../common/surface_generators.h"
 
 #include <string>
 #include <utility>
@@ -68,82 +69,7 @@ static const std::string Fragment_Shader_Source{ R"( // NOLINT(cert-err58-cpp)
     }
 )" };
 
-static asr::GeometryPair generate_sphere_geometry_data(
-    asr::GeometryType geometryType,
-    float radius,
-    unsigned int width_segments_count,
-    unsigned int height_segments_count,
-    glm::vec4 color = glm::vec4{ 1.0f, 1.0f, 1.0f, 1.0f }
-)
-{
-    assert(
-        geometryType == asr::GeometryType::Triangles ||
-        geometryType == asr::GeometryType::Lines ||
-        geometryType == asr::GeometryType::Points
-    );
-
-    asr::Vertices vertices;
-    asr::Indices indices;
-
-    for (auto i = 0U; i <= height_segments_count; ++i) {
-        float v{ static_cast<float>(i) / static_cast<float>(height_segments_count) };
-
-        float phi{ v * asr::pi };
-
-        for (auto j = 0U; j <= width_segments_count; ++j) {
-            float u{ static_cast<float>(j) / static_cast<float>(width_segments_count) };
-
-            float theta{ u * asr::two_pi };
-
-            float cos_phi{ std::cosf(phi) };
-            float sin_phi{ std::sinf(phi) };
-            float cos_theta{ std::cosf(theta) };
-            float sin_theta{ std::sinf(theta) };
-
-            float x{ cos_theta * sin_phi };
-            float y{ cos_phi };
-            float z{ sin_phi * sin_theta };
-
-            vertices.push_back(asr::Vertex{
-                x * radius, y * radius, z * radius,
-                color.r, color.g, color.b, color.a,
-                1.0f - u, v
-            });
-
-            if (geometryType == asr::GeometryType::Points)
-            {
-                indices.push_back(vertices.size() - 1);
-            }
-        }
-    }
-
-    if (geometryType == asr::GeometryType::Lines || geometryType == asr::GeometryType::Triangles) {
-        for (auto rows = 0U; rows < height_segments_count; ++rows) {
-            for (auto columns = 0U; columns < width_segments_count; ++columns) {
-                unsigned int index_a{ rows * (width_segments_count + 1) + columns };
-                unsigned int index_b{ index_a + 1 };
-                unsigned int index_c{ index_a + (width_segments_count + 1) };
-                unsigned int index_d{ index_c + 1 };
-
-                if (geometryType == asr::GeometryType::Lines) {
-                    indices.insert(indices.end(), { index_a, index_b, index_b, index_c, index_c, index_a });
-                    indices.insert(indices.end(), { index_b, index_d, index_d, index_c, index_c, index_b });
-                }
-                else {
-                    if (rows != 0)
-                    {
-                        indices.insert(indices.end(), { index_a, index_b, index_c });
-                    } if (rows != height_segments_count - 1)
-                    {
-                        indices.insert(indices.end(), { index_b, index_d, index_c });
-                    }
-                }
-            }
-        }
-    }
-
-    return std::make_pair(vertices, indices);
-}
+typedef surface_generators::PositionColorTexture<asr::Vertex> vertex_format;
 
 int main([[maybe_unused]] int argc, [[maybe_unused]] char** argv) {
     using namespace asr;
@@ -155,28 +81,14 @@ int main([[maybe_unused]] int argc, [[maybe_unused]] char** argv) {
     unsigned int width_segments{ 30 }, height_segments{ 30 };
 
     auto [triangle_vertices, triangle_indices] =
-        generate_sphere_geometry_data(
-            Triangles, radius, width_segments, height_segments
+        surface_generators::generate_sphere<vertex_format, surface_generators::TriangleTopology>(
+            radius, width_segments, height_segments
         );
     auto triangles =
         create_geometry(
             Triangles, triangle_vertices, triangle_indices
         );
 
-    glm::vec4 edge_color{ 1.0f, 0.7f, 0.7f, 1.0f };
-    auto [edge_vertices, edge_indices] =
-        generate_sphere_geometry_data(
-            Lines, radius * 1.005f, width_segments, height_segments, edge_color
-        );
-    auto lines = create_geometry(Lines, edge_vertices, edge_indices);
-
-    glm::vec4 vertex_color{ 1.0f, 0.0f, 0.0f, 1.0f };
-    auto [vertices, vertex_indices] =
-        generate_sphere_geometry_data(
-            Points, radius * 1.01f, width_segments, height_segments, vertex_color
-        );
-    auto points = create_geometry(Points, vertices, vertex_indices);
-
     glm::vec3 sphere_position{ 0.0f, 0.0f, 0.0f };
     glm::vec3 sphere_rotation{ 0.0f, 0.01f, 0.0f };
     glm::vec3 sphere_scale{ 1.0f, 1.0f, 1.0f };
@@ -328,8 +240,6 @@ int main([[maybe_unused]] int argc, [[maybe_unused]] char** argv) {
     }
 
     destroy_geometry(triangles);
-    destroy_geometry(lines);
-    destroy_geometry(points);
 
     destroy_shader();
     destroy_window();
@@ -1,4 +1,5 @@
 #include "asr.h"
+#include "../common/surface_generators.h"
 
 #include <cmath>
 #include <ctime>
@@ -70,105 +71,7 @@ static const std::string Fragment_Shader_Source{ R"( // NOLINT(cert-err58-cpp)
     }
 )" };
 
-static asr::GeometryPair generate_rectangle_geometry_data(
-    asr::GeometryType geometry_type,
-    float width, float height,
-    unsigned int width_segments_count,
-    unsigned int height_segments_count,
-    glm::vec4 color = glm::vec4{ 1.0f, 0.3f, 0.3f, 1.0f }
-)
-{
-    assert(
-        geometry_type == asr::GeometryType::Triangles
-    );
-
-    asr::Vertices vertices;
-    asr::Indices indices;
-
-    float half_height{ height * 0.5f };
-    float segment_height{ height / static_cast<float>(height_segments_count) };
-
-    float half_width{ width * 0.5f };
-    float segment_width{ width / static_cast<float>(width_segments_count) };
-
-    for (auto i = 0U; i <= height_segments_count; ++i) {
-        float y{ static_cast<float>(i) * segment_height - half_height };
-       
-        for (auto j = 0U; j <= width_segments_count; ++j) {
-            float x{ static_cast<float>(j) * segment_width - half_width };
-            
-            vertices.push_back(asr::Vertex{
-                x, y, 0.0f,
-                color.r, color.g, color.b, color.a
-            });
-        }
-    }
-
-    if (geometry_type == asr::GeometryType::Triangles) {
-        for (auto i = 0U; i < height_segments_count; ++i) {
-            for (auto j = 0U; j < width_segments_count; ++j) {
-                unsigned int index_a{ i * (width_segments_count + 1) + j };
-                unsigned int index_b{ index_a + 1 };
-                unsigned int index_c{ index_a + (width_segments_count + 1) };
-                unsigned int index_d{ index_c + 1 };
-             
-                indices.insert(indices.end(), { index_a, index_b, index_c });
-                indices.insert(indices.end(), { index_b, index_d, index_c });
-            }
-        }
-    }
-
-    return std::make_pair(vertices, indices);
-}
-
-static asr::GeometryPair generate_circle_geometry_data(
-    asr::GeometryType geometry_type,
-    float radius, unsigned int segment_count,
-    glm::vec4 color = glm::vec4{ 1.0f, 0.3f, 0.3f, 1.0f }
-)
-{
-    assert(
-        geometry_type == asr::GeometryType::Triangles
-    );
-
-    asr::Vertices vertices;
-    asr::Indices indices;
-
-    vertices.push_back(asr::Vertex{
-        0.0f, 0.0f, 0.0f,
-        color.r, color.g, color.b, color.a
-    });
-    
-    float angle{ 0.0f };
-    float angle_delta{ asr::two_pi / static_cast<float>(segment_count) };
-
-    float x{ std::cosf(angle) * radius };
-    float y{ std::sinf(angle) * radius };
- 
-    vertices.push_back(asr::Vertex{
-        x, y, 0.0f,
-        color.r, color.g, color.b, color.a,
-    });
-
-    for (auto i = 0U; i < segment_count; ++i) {
-        if (geometry_type == asr::GeometryType::Triangles) {
-            indices.push_back(0);
-            indices.push_back(vertices.size() - 1);
-        }
-        float next_x{ std::cosf(angle + angle_delta) * radius };
-        float next_y{ std::sinf(angle + angle_delta) * radius };
-
-        vertices.push_back(asr::Vertex{
-            next_x, next_y, 0.0f,
-            color.r, color.g, color.b, color.a
-        });
-        indices.push_back(vertices.size() - 1);
-
-        angle += angle_delta;
-    }
-
-    return std::make_pair(vertices, indices);
-}
+typedef surface_generators::PositionColorTexture<asr::Vertex> vertex_format;
 
 int main([[maybe_unused]] int argc, [[maybe_unused]] char** argv)
 {
@@ -189,23 +92,23 @@ int main([[maybe_unused]] int argc, [[maybe_unused]] char** argv)
     unsigned int circle_segments{ 30U };
 
     glm::vec4 circle_min_color{ 1.0f, 1.0f, 1.0f, 1.0f };
-    auto [triangle_vertices_minutes, triangle_indices_minutes] = generate_circle_geometry_data(Triangles, radius, circle_segments, circle_min_color);
-    auto trianglesCircleMinutes = create_geometry(Triangles, triangle_vertices_minutes, triangle_indices_minutes);
+    auto [triangle_vertices_minutes, triangle_indices_minutes] = surface_generators::generate_circle<vertex_format, surface_generators::TriangleFanTopology>(radius, circle_segments, circle_min_color);
+    auto trianglesCircleMinutes = create_geometry(TriangleFan, triangle_vertices_minutes, triangle_indices_minutes);
 
     glm::vec4 circle_centre_color{ 1.0f, 0.3f, 0.3f, 1.0f };
-    auto [triangle_vertices_centre, triangle_indices_centre] = generate_circle_geometry_data(Triangles, radius, circle_segments, circle_centre_color);
-    auto trianglesCircleCentre = create_geometry(Triangles, triangle_vertices_centre, triangle_indices_centre);
+    auto [triangle_vertices_centre, triangle_indices_centre] = surface_generators::generate_circle<vertex_format, surface_generators::TriangleFanTopology>(radius, circle_segments, circle_centre_color);
+    auto trianglesCircleCentre = create_geometry(TriangleFan, triangle_vertices_centre, triangle_indices_centre);
 
     float width{ 0.09f }, height{ 0.09f };
     unsigned int width_segments{ 1U }, height_segments{ 1U };
 
     glm::vec4 rect_color_one{ 1.0f, 0.0f, 0.0f, 1.0f };
-    auto [triangle_vertices_rect_one, triangle_indices_rect_one] = generate_rectangle_geometry_data(Triangles, width, height, width_segments, height_segments,rect_color_one);
-    auto trianglesRectOne = create_geometry(Triangles, triangle_vertices_rect_one, triangle_indices_rect_one);
+    auto [triangle_vertices_rect_one, triangle_indices_rect_one] = surface_generators::generate_rectangle<vertex_format, surface_generators::TriangleStripTopology>(width, height, width_segments, height_segments,rect_color_one);
+    auto trianglesRectOne = create_geometry(TriangleStrip, triangle_vertices_rect_one, triangle_indices_rect_one);
 
     glm::vec4 rect_color_two{ 1.0f, 0.3f, 0.3f, 1.0f };
-    auto [triangle_vertices_rect_two, triangle_indices_rect_two] = generate_rectangle_geometry_data(Triangles, width, height, width_segments, height_segments, rect_color_two);
-    auto trianglesRectTwo = create_geometry(Triangles, triangle_vertices_rect_two, triangle_indices_rect_two);
+    auto [triangle_vertices_rect_two, triangle_indices_rect_two] = surface_generators::generate_rectangle<vertex_format, surface_generators::TriangleStripTopology>(width, height, width_segments, height_segments, rect_color_two);
+    auto trianglesRectTwo = create_geometry(TriangleStrip, triangle_vertices_rect_two, triangle_indices_rect_two);
 
 
     prepare_for_rendering();
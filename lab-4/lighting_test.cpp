@@ -1,11 +1,179 @@
 #include "asr.h"
-
+#include "../common/surface_generators.h"
+#include "../common/transforms.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <new>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 #include <SDL.h>
 #undef main
 
+static const size_t FRAME_ARENA_CAPACITY{65536};
+static const size_t STATIC_ARENA_CAPACITY{4096};
+static const unsigned int ALLOCATION_CHECK_WARM_UP_FRAMES{3};
+static const unsigned int STATISTICS_PASS_COUNT{3};
+
+// Fixed meshes are generated by the compiler; startup only converts them.
+static constexpr auto PLANE_MESH{fixed_meshes::make_quad(500.0f, 500.0f)};
+static constexpr auto SPHERE_MESH{fixed_meshes::make_sphere<40, 40>(0.025f)};
+
+// Every heap allocation in the program goes through here, in every form of
+// operator new, so a section of the frame can check that it did not
+// allocate by comparing two readings.
+static std::atomic<size_t> Allocation_Count{0}; // NOLINT(cert-err58-cpp)
+
+// Over-aligned blocks are carved out of a larger malloc block, with the
+// pointer malloc returned stored just before them.
+static void* allocate_counted(size_t size, size_t alignment = alignof(std::max_align_t)) noexcept
+{
+    ++Allocation_Count;
+    if (size == 0) {
+        size = 1;
+    }
+    if (alignment <= alignof(std::max_align_t)) {
+        return std::malloc(size);
+    }
+
+    void* block = std::malloc(size + alignment + sizeof(void*));
+    if (block == nullptr) {
+        return nullptr;
+    }
+    uintptr_t address{(reinterpret_cast<uintptr_t>(block) + sizeof(void*) + alignment - 1) / alignment * alignment};
+    reinterpret_cast<void**>(address)[-1] = block;
+
+    return reinterpret_cast<void*>(address);
+}
+
+static void free_counted(void* memory, size_t alignment = alignof(std::max_align_t)) noexcept
+{
+    if (memory == nullptr) {
+        return;
+    }
+    std::free(alignment <= alignof(std::max_align_t) ? memory : static_cast<void**>(memory)[-1]);
+}
+
+static void* allocate_counted_or_throw(size_t size, size_t alignment = alignof(std::max_align_t))
+{
+    if (void* memory = allocate_counted(size, alignment)) {
+        return memory;
+    }
+    throw std::bad_alloc{};
+}
+
+void* operator new(size_t size)
+{
+    return allocate_counted_or_throw(size);
+}
+
+void* operator new[](size_t size)
+{
+    return allocate_counted_or_throw(size);
+}
+
+void* operator new(size_t size, std::align_val_t alignment)
+{
+    return allocate_counted_or_throw(size, static_cast<size_t>(alignment));
+}
+
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+    return allocate_counted_or_throw(size, static_cast<size_t>(alignment));
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate_counted(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate_counted(size);
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return allocate_counted(size, static_cast<size_t>(alignment));
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return allocate_counted(size, static_cast<size_t>(alignment));
+}
+
+void operator delete(void* memory) noexcept
+{
+    free_counted(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+    free_counted(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+    free_counted(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept
+{
+    free_counted(memory);
+}
+
+void operator delete(void* memory, std::align_val_t alignment) noexcept
+{
+    free_counted(memory, static_cast<size_t>(alignment));
+}
+
+void operator delete[](void* memory, std::align_val_t alignment) noexcept
+{
+    free_counted(memory, static_cast<size_t>(alignment));
+}
+
+void operator delete(void* memory, size_t, std::align_val_t alignment) noexcept
+{
+    free_counted(memory, static_cast<size_t>(alignment));
+}
+
+void operator delete[](void* memory, size_t, std::align_val_t alignment) noexcept
+{
+    free_counted(memory, static_cast<size_t>(alignment));
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept
+{
+    free_counted(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept
+{
+    free_counted(memory);
+}
+
+void operator delete(void* memory, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    free_counted(memory, static_cast<size_t>(alignment));
+}
+
+void operator delete[](void* memory, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    free_counted(memory, static_cast<size_t>(alignment));
+}
 
 static const std::string Vertex_Shader_Source{R"( // NOLINT(cert-err58-cpp)
     #version 110
@@ -15,9 +183,9 @@ static const std::string Vertex_Shader_Source{R"( // NOLINT(cert-err58-cpp)
     attribute vec4 color;
     attribute vec4 texture_coordinates;
 
-    uniform mat4 model_view_matrix;
+    uniform mat4 object_model_view_matrix;
     uniform mat4 projection_matrix;
-    uniform mat3 normal_matrix;
+    uniform mat3 object_normal_matrix;
 
     uniform float point_size;
 
@@ -32,10 +200,10 @@ static const std::string Vertex_Shader_Source{R"( // NOLINT(cert-err58-cpp)
 
     void main()
     {
-        vec4 view_position = model_view_matrix * position;
+        vec4 view_position = object_model_view_matrix * position;
         fragment_view_position = view_position;
         fragment_view_direction = -view_position.xyz;
-        fragment_view_normal = normalize(normal_matrix * normal);
+        fragment_view_normal = normalize(object_normal_matrix * normal);
 
         fragment_color = color;
         if (texture_enabled) {
@@ -204,155 +372,575 @@ static const std::string Fragment_Shader_Source{R"( // NOLINT(cert-err58-cpp)
     }
 )"};
 
-static asr::GeometryPair generate_rectangle_geometry_data(
-                             asr::GeometryType geometry_type,
-                             float width, float height,
-                             unsigned int width_segments_count,
-                             unsigned int height_segments_count,
-                             glm::vec4 color = glm::vec4{1.0f, 1.0f, 1.0f, 1.0f}
-                         )
+typedef surface_generators::PositionNormalColorTexture<asr::Vertex> vertex_format;
+
+// Linear allocator over one block reserved at startup. Allocation bumps an
+// atomic offset, so recording threads can share an arena; nothing is freed
+// individually and reset() releases everything at once. A per-frame arena
+// is reset at the start of every frame, before anything allocated from it
+// in the previous frame is used again.
+class FrameArena {
+public:
+    explicit FrameArena(size_t capacity) :
+        _memory{static_cast<uint8_t*>(::operator new(capacity))},
+        _capacity{capacity}
+    { }
+
+    ~FrameArena()
+    {
+        ::operator delete(_memory);
+    }
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    [[nodiscard]] void* allocate(size_t size, size_t alignment = alignof(std::max_align_t))
+    {
+        size_t aligned_size{(size + alignment - 1) / alignment * alignment};
+        size_t offset{_offset.fetch_add(aligned_size)};
+        if (offset + aligned_size > _capacity) {
+            throw std::bad_alloc{};
+        }
+
+        return _memory + offset;
+    }
+
+    void reset()
+    {
+        size_t used{_offset.exchange(0)};
+        if (used > _high_water_mark) {
+            _high_water_mark = used;
+        }
+    }
+
+    [[nodiscard]] size_t get_used() const
+    {
+        return _offset;
+    }
+
+    [[nodiscard]] size_t get_capacity() const
+    {
+        return _capacity;
+    }
+
+    [[nodiscard]] size_t get_high_water_mark() const
+    {
+        return _high_water_mark;
+    }
+
+private:
+    uint8_t* _memory;
+    size_t _capacity;
+    std::atomic<size_t> _offset{0};
+    size_t _high_water_mark{0};
+};
+
+// Geometry as the command buffers see it: asr does not report the size of
+// its geometry, so the counts are kept next to the handle for statistics.
+struct DrawableGeometry {
+    asr::Geometry* geometry;
+    asr::GeometryType type;
+    unsigned int vertex_count;
+    unsigned int index_count;
+};
+
+// Work submitted to asr, counted while command buffers are replayed.
+// Uniform uploads are material parameters, transform updates are the
+// cached matrices of an object uploaded for its draws. Buffer bytes are
+// geometry data sent to the GPU.
+struct RenderStatistics {
+    unsigned int draw_calls{0};
+    unsigned int triangles{0};
+    unsigned int vertices{0};
+    unsigned int uniform_uploads{0};
+    unsigned int transform_updates{0};
+    size_t buffer_bytes{0};
+
+    RenderStatistics& operator+=(const RenderStatistics& other)
+    {
+        draw_calls += other.draw_calls;
+        triangles += other.triangles;
+        vertices += other.vertices;
+        uniform_uploads += other.uniform_uploads;
+        transform_updates += other.transform_updates;
+        buffer_bytes += other.buffer_bytes;
+        return *this;
+    }
+};
+
+static void write_statistics_csv_header(std::ostream& output)
 {
-    assert(
-        geometry_type == asr::GeometryType::Triangles ||
-        geometry_type == asr::GeometryType::Lines     ||
-        geometry_type == asr::GeometryType::Points
-    );
-
-    asr::Vertices vertices;
-    asr::Indices indices;
-
-    float half_height{height * 0.5f};
-    float segment_height{height / static_cast<float>(height_segments_count)};
-
-    float half_width{width * 0.5f};
-    float segment_width{width / static_cast<float>(width_segments_count)};
-
-    for (auto i = 0U; i <= height_segments_count; ++i) {
-        float y{static_cast<float>(i) * segment_height - half_height};
-        float v{1.0f - static_cast<float>(i) / static_cast<float>(height_segments_count)};
-        for (auto j = 0U; j <= width_segments_count; ++j) {
-            float x{static_cast<float>(j) * segment_width - half_width};
-            float u{static_cast<float>(j) / static_cast<float>(width_segments_count)};
-            vertices.push_back(asr::Vertex{
-                x, y, 0.0f,
-                0.0f, 0.0f, 1.0f,
-                color.r, color.g, color.b, color.a,
-                u, v
-            });
-            if (geometry_type == asr::GeometryType::Points) {
-                indices.push_back(vertices.size() - 1);
-            }
+    output << "frame,pass,draw_calls,triangles,vertices,uniform_uploads,transform_updates,buffer_bytes\n";
+}
+
+static void write_statistics_csv_row(std::ostream& output, unsigned int frame, const char* pass, const RenderStatistics& statistics)
+{
+    output << frame << ',' << pass << ','
+           << statistics.draw_calls << ',' << statistics.triangles << ',' << statistics.vertices << ','
+           << statistics.uniform_uploads << ',' << statistics.transform_updates << ','
+           << statistics.buffer_bytes << '\n';
+}
+
+// Model-view and normal matrices of the objects the command buffers draw.
+// asr derives its matrices from the matrix stack on every draw, so the
+// shader reads these instead, uploaded by upload(). Every object remembers
+// the versions of its transform and of the camera its matrices were
+// computed for; update() recomputes only the objects where either changed,
+// in one pass over packed arrays between recording and replay. set() may
+// be called for different objects from different recording threads.
+// Normal matrices assume a rigid view matrix: with a uniform scale the
+// normal matrix is the model-view matrix divided by the size of the scale,
+// which keeps the sign of a mirroring scale, any other scale takes the
+// inverse-transpose. Both equal the inverse-transpose up to a positive
+// factor, so mirrored objects keep outward normals on both paths. An object
+// scaled to nothing gets the identity.
+class TransformCache {
+public:
+    typedef unsigned int object_type;
+
+    [[nodiscard]] object_type add(const glm::vec3& position, const glm::vec3& rotation, const glm::vec3& scale)
+    {
+        auto object = static_cast<object_type>(_positions.size());
+        _positions.push_back(position);
+        _rotations.push_back(rotation);
+        _scales.push_back(scale);
+        _uniform_scales.push_back(_uniform_scale(scale));
+        _transform_versions.push_back(1);
+        _cached_transform_versions.push_back(0);
+        _cached_camera_versions.push_back(0);
+        _model_matrices.emplace_back(1.0f);
+        _model_view_matrices.emplace_back(1.0f);
+        _normal_matrices.emplace_back(1.0f);
+        _uniform_scale_objects.reserve(_positions.size());
+        _scaled_objects.reserve(_positions.size());
+
+        return object;
+    }
+
+    void set(object_type object, const glm::vec3& position, const glm::vec3& rotation, const glm::vec3& scale)
+    {
+        if (position == _positions[object] && rotation == _rotations[object] && scale == _scales[object]) {
+            return;
         }
+        _positions[object] = position;
+        _rotations[object] = rotation;
+        _scales[object] = scale;
+        _uniform_scales[object] = _uniform_scale(scale);
+        ++_transform_versions[object];
     }
 
-    if (geometry_type == asr::GeometryType::Lines || geometry_type == asr::GeometryType::Triangles) {
-        for (auto i = 0U; i < height_segments_count; ++i) {
-            for (auto j = 0U; j < width_segments_count; ++j) {
-                unsigned int index_a{i * (width_segments_count + 1) + j};
-                unsigned int index_b{index_a + 1};
-                unsigned int index_c{index_a + (width_segments_count + 1)};
-                unsigned int index_d{index_c + 1};
-                if (geometry_type == asr::GeometryType::Lines) {
-                    indices.insert(indices.end(), {
-                        index_a, index_b, index_b, index_c, index_c, index_a
-                    });
-                    indices.insert(indices.end(), {
-                        index_b, index_d, index_d, index_c, index_c, index_b
-                    });
+    // The view matrix transforms world space into view space. Returns the
+    // number of objects whose matrices were recomputed.
+    unsigned int update(const glm::mat4& view_matrix, unsigned int camera_version)
+    {
+        _uniform_scale_objects.clear();
+        _scaled_objects.clear();
+        for (object_type object = 0; object < _positions.size(); ++object) {
+            bool transform_changed{_cached_transform_versions[object] != _transform_versions[object]};
+            if (transform_changed) {
+                _model_matrices[object] = transforms::make_model_matrix(_positions[object], _rotations[object], _scales[object]);
+                _cached_transform_versions[object] = _transform_versions[object];
+            }
+            if (transform_changed || _cached_camera_versions[object] != camera_version) {
+                _cached_camera_versions[object] = camera_version;
+                if (_uniform_scales[object] != 0.0f) {
+                    _uniform_scale_objects.push_back(object);
                 } else {
-                    indices.insert(indices.end(), {index_a, index_b, index_c});
-                    indices.insert(indices.end(), {index_b, index_d, index_c});
+                    _scaled_objects.push_back(object);
                 }
             }
         }
+
+        for (auto object : _uniform_scale_objects) {
+            const glm::mat4& model_view_matrix = _model_view_matrices[object] = view_matrix * _model_matrices[object];
+            _normal_matrices[object] = glm::mat3(model_view_matrix) * (1.0f / _uniform_scales[object]);
+        }
+        // The inverse-transpose is the cofactor matrix over the determinant,
+        // and the cofactor columns are cross products of the other two columns.
+        for (auto object : _scaled_objects) {
+            const glm::mat4& model_view_matrix = _model_view_matrices[object] = view_matrix * _model_matrices[object];
+            glm::vec3 x{model_view_matrix[0]}, y{model_view_matrix[1]}, z{model_view_matrix[2]};
+            glm::mat3 cofactors{glm::cross(y, z), glm::cross(z, x), glm::cross(x, y)};
+            float determinant{glm::dot(x, cofactors[0])};
+            _normal_matrices[object] = determinant != 0.0f ? cofactors * (1.0f / determinant) : glm::mat3{1.0f};
+        }
+
+        return static_cast<unsigned int>(_uniform_scale_objects.size() + _scaled_objects.size());
     }
 
-    return std::make_pair(vertices, indices);
-}
+    // Uploads the matrices of an object to the program of the current
+    // material. The test draws everything with one material, so its program
+    // and the uniform locations are looked up on the first upload only.
+    void upload(object_type object)
+    {
+        if (_program == 0) {
+            GLint program{0};
+            glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+            _program = static_cast<GLuint>(program);
+            _model_view_location = glGetUniformLocation(_program, "object_model_view_matrix");
+            _normal_location = glGetUniformLocation(_program, "object_normal_matrix");
+        }
 
-static asr::GeometryPair generate_sphere_geometry_data(
-                             asr::GeometryType geometry_type,
-                             float radius,
-                             unsigned int width_segments_count,
-                             unsigned int height_segments_count,
-                             glm::vec4 color = glm::vec4{1.0f, 1.0f, 1.0f, 1.0f} 
-                         )
-{
-    assert(
-        geometry_type == asr::GeometryType::Triangles ||
-        geometry_type == asr::GeometryType::Lines     ||
-        geometry_type == asr::GeometryType::Points
-    );
-
-    asr::Vertices vertices;
-    asr::Indices indices;
-
-    for (auto i = 0U; i <= height_segments_count; ++i) {
-        float v{static_cast<float>(i) / static_cast<float>(height_segments_count)};
-        float phi{v * asr::pi};
-
-        for (auto j = 0U; j <= width_segments_count; ++j) {
-            float u{static_cast<float>(j) / static_cast<float>(width_segments_count)};
-            float theta{u * asr::two_pi};
-
-            float cos_phi{std::cos(phi)};
-            float sin_phi{std::sin(phi)};
-            float cos_theta{std::cos(theta)};
-            float sin_theta{std::sin(theta)};
-
-            float x{cos_theta * sin_phi};
-            float y{cos_phi};
-            float z{sin_phi * sin_theta};
-
-            vertices.push_back(asr::Vertex{
-                x * radius, y * radius, z * radius,
-                x, y, z,
-                color.r, color.g, color.b, color.a,
-                1.0f - u, v
-            });
-            if (geometry_type == asr::GeometryType::Points) {
-                indices.push_back(vertices.size() - 1);
+        glUniformMatrix4fv(_model_view_location, 1, GL_FALSE, &_model_view_matrices[object][0][0]);
+        glUniformMatrix3fv(_normal_location, 1, GL_FALSE, &_normal_matrices[object][0][0]);
+    }
+
+private:
+    std::vector<glm::vec3> _positions, _rotations, _scales;
+    // The size of the scale of objects scaled equally along every axis, zero
+    // for other scales and for no scale at all.
+    std::vector<float> _uniform_scales;
+    std::vector<unsigned int> _transform_versions, _cached_transform_versions, _cached_camera_versions;
+    std::vector<glm::mat4> _model_matrices, _model_view_matrices;
+    std::vector<glm::mat3> _normal_matrices;
+    std::vector<object_type> _uniform_scale_objects, _scaled_objects;
+
+    GLuint _program{0};
+    GLint _model_view_location{-1}, _normal_location{-1};
+
+    [[nodiscard]] static float _uniform_scale(const glm::vec3& scale)
+    {
+        return scale.x == scale.y && scale.y == scale.z ? std::abs(scale.x) : 0.0f;
+    }
+};
+
+// Rendering commands recorded into one linear block of memory and replayed
+// in order on the rendering thread. Recording does not touch asr state, so
+// independent parts of the frame can be recorded on different threads and
+// static parts can be recorded once and replayed every frame. Parameter
+// names are stored as pointers and must outlive the buffer (string literals).
+// The memory comes from an arena: a buffer recorded from a per-frame arena
+// must be cleared after the arena is reset and before it is recorded again.
+class CommandBuffer {
+public:
+    explicit CommandBuffer(FrameArena& arena) : _arena{&arena} { }
+
+    // The matrices of the object are read from the cache given to replay().
+    void set_model_transform(TransformCache::object_type object)
+    {
+        _push(SetModelTransform, ModelTransformCommand{ object });
+    }
+
+    void set_geometry(const DrawableGeometry& geometry)
+    {
+        _push(SetGeometry, GeometryCommand{ geometry });
+    }
+
+    void set_parameter(const char* name, bool value)
+    {
+        _push(SetBoolParameter, ParameterCommand<bool>{ name, value });
+    }
+
+    void set_parameter(const char* name, float value)
+    {
+        _push(SetFloatParameter, ParameterCommand<float>{ name, value });
+    }
+
+    void set_parameter(const char* name, const glm::vec3& value)
+    {
+        _push(SetVec3Parameter, ParameterCommand<glm::vec3>{ name, value });
+    }
+
+    void set_parameter(const char* name, const glm::vec4& value)
+    {
+        _push(SetVec4Parameter, ParameterCommand<glm::vec4>{ name, value });
+    }
+
+    void draw()
+    {
+        _push(Draw, DrawCommand{});
+    }
+
+    void clear()
+    {
+        _commands = nullptr;
+        _size = 0;
+        _capacity = 0;
+    }
+
+    // Counts the submitted work into statistics when it is given.
+    void replay(TransformCache& transforms, RenderStatistics* statistics = nullptr) const
+    {
+        using namespace asr;
+
+        RenderStatistics counted;
+        DrawableGeometry current_geometry{ nullptr, Triangles, 0, 0 };
+        size_t offset{ 0 };
+        while (offset < _size) {
+            auto type = static_cast<CommandType>(_commands[offset]);
+            offset += COMMAND_ALIGNMENT;
+
+            switch (type) {
+                case SetModelTransform: {
+                    auto command = _read<ModelTransformCommand>(offset);
+                    transforms.upload(command.object);
+                    ++counted.transform_updates;
+                    break;
+                }
+                case SetGeometry: {
+                    current_geometry = _read<GeometryCommand>(offset).geometry;
+                    set_geometry_current(current_geometry.geometry);
+                    break;
+                }
+                case SetBoolParameter: {
+                    auto command = _read<ParameterCommand<bool>>(offset);
+                    set_material_parameter(command.name, command.value);
+                    ++counted.uniform_uploads;
+                    break;
+                }
+                case SetFloatParameter: {
+                    auto command = _read<ParameterCommand<float>>(offset);
+                    set_material_parameter(command.name, command.value);
+                    ++counted.uniform_uploads;
+                    break;
+                }
+                case SetVec3Parameter: {
+                    auto command = _read<ParameterCommand<glm::vec3>>(offset);
+                    set_material_parameter(command.name, command.value);
+                    ++counted.uniform_uploads;
+                    break;
+                }
+                case SetVec4Parameter: {
+                    auto command = _read<ParameterCommand<glm::vec4>>(offset);
+                    set_material_parameter(command.name, command.value);
+                    ++counted.uniform_uploads;
+                    break;
+                }
+                case Draw: {
+                    _read<DrawCommand>(offset);
+                    render_current_geometry();
+                    ++counted.draw_calls;
+                    counted.vertices += current_geometry.vertex_count;
+                    if (current_geometry.type == Triangles) {
+                        counted.triangles += current_geometry.index_count / 3;
+                    }
+                    break;
+                }
             }
         }
+
+        if (statistics != nullptr) {
+            *statistics += counted;
+        }
     }
 
-    if (geometry_type == asr::GeometryType::Lines || geometry_type == asr::GeometryType::Triangles) {
-        for (auto rows = 0U; rows < height_segments_count; ++rows) {
-            for (auto columns = 0U; columns < width_segments_count; ++columns) {
-                unsigned int index_a{rows * (width_segments_count + 1) + columns};
-                unsigned int index_b{index_a + 1};
-                unsigned int index_c{index_a + (width_segments_count + 1)};
-                unsigned int index_d{index_c + 1};
-                if (geometry_type == asr::GeometryType::Lines) {
-                    if (rows != 0) {
-                        indices.insert(indices.end(), {
-                            index_a, index_b, index_b, index_c, index_c, index_a
-                        });
-                    }
-                    if (rows != height_segments_count - 1) {
-                        indices.insert(indices.end(), {
-                            index_b, index_d, index_d, index_c, index_c, index_b
-                        });
-                    }
-                } else {
-                    if (rows != 0) {
-                        indices.insert(indices.end(), {index_a, index_b, index_c});
-                    }
-                    if (rows != height_segments_count - 1) {
-                        indices.insert(indices.end(), {index_b, index_d, index_c});
-                    }
+private:
+    enum CommandType : uint8_t {
+        SetModelTransform,
+        SetGeometry,
+        SetBoolParameter,
+        SetFloatParameter,
+        SetVec3Parameter,
+        SetVec4Parameter,
+        Draw
+    };
+
+    struct ModelTransformCommand {
+        TransformCache::object_type object;
+    };
+
+    struct GeometryCommand {
+        DrawableGeometry geometry;
+    };
+
+    template<typename T>
+    struct ParameterCommand {
+        const char* name;
+        T value;
+    };
+
+    struct DrawCommand {
+    };
+
+    static const size_t COMMAND_ALIGNMENT{ alignof(std::max_align_t) };
+    static const size_t INITIAL_CAPACITY{ 256 };
+
+    FrameArena* _arena;
+    uint8_t* _commands{ nullptr };
+    size_t _size{ 0 };
+    size_t _capacity{ 0 };
+
+    [[nodiscard]] static size_t _aligned(size_t size)
+    {
+        return (size + COMMAND_ALIGNMENT - 1) / COMMAND_ALIGNMENT * COMMAND_ALIGNMENT;
+    }
+
+    template<typename Command>
+    void _push(CommandType type, const Command& command)
+    {
+        size_t offset = _size;
+        size_t size = offset + COMMAND_ALIGNMENT + _aligned(sizeof(Command));
+        if (size > _capacity) {
+            // The old block stays in the arena until it is reset.
+            size_t capacity = std::max({ _capacity * 2, size, INITIAL_CAPACITY });
+            auto commands = static_cast<uint8_t*>(_arena->allocate(capacity));
+            if (_size > 0) {
+                std::memcpy(commands, _commands, _size);
+            }
+            _commands = commands;
+            _capacity = capacity;
+        }
+        _size = size;
+        _commands[offset] = type;
+        std::memcpy(&_commands[offset + COMMAND_ALIGNMENT], &command, sizeof(Command));
+    }
+
+    template<typename Command>
+    Command _read(size_t& offset) const
+    {
+        Command command;
+        std::memcpy(&command, &_commands[offset], sizeof(Command));
+        offset += _aligned(sizeof(Command));
+        return command;
+    }
+};
+
+// Threads that record command buffers. record() hands out partitions to the
+// workers and to the calling thread and returns once all of them are done.
+class CommandRecorders {
+public:
+    explicit CommandRecorders(unsigned int thread_count)
+    {
+        for (auto i = 0U; i < thread_count; ++i) {
+            _threads.emplace_back([this] { _run(); });
+        }
+    }
+
+    ~CommandRecorders()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stopping = true;
+        }
+        _work_available.notify_all();
+        for (auto& thread : _threads) {
+            thread.join();
+        }
+    }
+
+    CommandRecorders(const CommandRecorders&) = delete;
+    CommandRecorders& operator=(const CommandRecorders&) = delete;
+
+    template<typename Record>
+    void record(unsigned int partition_count, Record& record)
+    {
+        Work work;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _work.task = [](void* context, unsigned int partition) { (*static_cast<Record*>(context))(partition); };
+            _work.context = &record;
+            _work.partition_count = partition_count;
+            ++_work.generation;
+            _next_claim = static_cast<uint64_t>(_work.generation) << 32U;
+            _finished_partitions = 0;
+            work = _work;
+        }
+        _work_available.notify_all();
+
+        _record_partitions(work);
+
+        std::unique_lock<std::mutex> lock(_mutex);
+        _work_finished.wait(lock, [this] { return _finished_partitions == _work.partition_count; });
+    }
+
+private:
+    std::vector<std::thread> _threads;
+    std::mutex _mutex;
+    std::condition_variable _work_available, _work_finished;
+    bool _stopping{ false };
+
+    // The work of one record() call. Every thread copies it under the mutex
+    // and records from its copy.
+    struct Work {
+        void (*task)(void*, unsigned int){ nullptr };
+        void* context{ nullptr };
+        unsigned int partition_count{ 0 };
+        uint32_t generation{ 0 };
+    };
+
+    Work _work;
+    // The generation in the high half and the next partition of it in the
+    // low half, so a thread still looping over an earlier generation cannot
+    // claim a partition of the current one.
+    std::atomic<uint64_t> _next_claim{ 0 };
+    unsigned int _finished_partitions{ 0 };
+
+    void _record_partitions(const Work& work)
+    {
+        uint64_t claim{ _next_claim.load() };
+        for (;;) {
+            auto partition = static_cast<unsigned int>(claim & 0xFFFFFFFFU);
+            if ((claim >> 32U) != work.generation || partition >= work.partition_count) {
+                return;
+            }
+            if (!_next_claim.compare_exchange_weak(claim, claim + 1)) {
+                continue;
+            }
+            work.task(work.context, partition);
+
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                if (++_finished_partitions == work.partition_count) {
+                    _work_finished.notify_all();
                 }
             }
+            claim = _next_claim.load();
         }
     }
 
-    return std::make_pair(vertices, indices);
-}
+    void _run()
+    {
+        uint32_t generation{ 0 };
+        for (;;) {
+            Work work;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _work_available.wait(lock, [&] { return _stopping || _work.generation != generation; });
+                if (_stopping) {
+                    return;
+                }
+                work = _work;
+                generation = work.generation;
+            }
+            _record_partitions(work);
+        }
+    }
+};
 
-int main()
+int main(int argc, char** argv)
 {
     using namespace asr;
 
+    // Render statistics. --statistics-csv writes every pass of every frame,
+    // the --max-* options are budgets for a frame that make the test fail
+    // and --frames stops it after the given number of frames.
+
+    std::string statistics_file;
+    RenderStatistics budget{};
+    unsigned int frame_limit{0};
+    auto parse_count = [](const char* value) { return static_cast<unsigned int>(std::strtoul(value, nullptr, 10)); };
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::strcmp(argv[i], "--statistics-csv") == 0) {
+            statistics_file = argv[i + 1];
+        } else if (std::strcmp(argv[i], "--max-draw-calls") == 0) {
+            budget.draw_calls = parse_count(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--max-triangles") == 0) {
+            budget.triangles = parse_count(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--max-vertices") == 0) {
+            budget.vertices = parse_count(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--max-uniform-uploads") == 0) {
+            budget.uniform_uploads = parse_count(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--frames") == 0) {
+            frame_limit = parse_count(argv[i + 1]);
+        }
+    }
+
+    std::ofstream statistics_output;
+    if (!statistics_file.empty()) {
+        statistics_output.open(statistics_file);
+        write_statistics_csv_header(statistics_output);
+    }
+
     create_window("Lighting Test on ASR Version 1.3");
 
     // Material
@@ -400,14 +988,32 @@ int main()
 
     // Plane Geometry
 
-    auto [plane_geometry_vertices, plane_geometry_indices] = generate_rectangle_geometry_data(Triangles, 500.0f, 500.0f, 1U, 1U);
+    auto [plane_geometry_vertices, plane_geometry_indices] = surface_generators::copy_fixed_mesh<vertex_format>(PLANE_MESH);
     auto plane_geometry = create_geometry(Triangles, plane_geometry_vertices, plane_geometry_indices);
 
     // Sphere Geometry
 
-    auto [sphere_geometry_vertices, sphere_geometry_indices] = generate_sphere_geometry_data(Triangles, 0.025f, 40U, 40U);
+    auto [sphere_geometry_vertices, sphere_geometry_indices] = surface_generators::copy_fixed_mesh<vertex_format>(SPHERE_MESH);
     auto sphere_geometry = create_geometry(Triangles, sphere_geometry_vertices, sphere_geometry_indices);
 
+    DrawableGeometry plane_drawable{
+        &plane_geometry, Triangles,
+        static_cast<unsigned int>(plane_geometry_vertices.size()), static_cast<unsigned int>(plane_geometry_indices.size())
+    };
+    DrawableGeometry sphere_drawable{
+        &sphere_geometry, Triangles,
+        static_cast<unsigned int>(sphere_geometry_vertices.size()), static_cast<unsigned int>(sphere_geometry_indices.size())
+    };
+
+    RenderStatistics setup_statistics;
+    for (const auto& drawable : {plane_drawable, sphere_drawable}) {
+        setup_statistics.buffer_bytes +=
+            drawable.vertex_count * sizeof(Vertex) + drawable.index_count * sizeof(Indices::value_type);
+    }
+    if (statistics_output.is_open()) {
+        write_statistics_csv_row(statistics_output, 0, "setup", setup_statistics);
+    }
+
     prepare_for_rendering();
 
     set_material_current(&material);
@@ -470,6 +1076,14 @@ int main()
     set_matrix_mode(Projection);
     load_perspective_projection_matrix(CAMERA_FOV, CAMERA_NEAR_PLANE, CAMERA_FAR_PLANE);
 
+    // Matrices derived from the camera are cached against camera_version,
+    // which changes only on frames where the camera has moved.
+    unsigned int camera_version{1};
+    glm::vec3 versioned_camera_position{camera_position};
+    glm::vec3 versioned_camera_rotation{camera_rotation};
+    glm::mat4 view_matrix_inverted{1.0f};
+    unsigned int view_matrix_inverted_version{0};
+
     // Plane Parameters
 
     glm::vec3 plane_position{0.0f, 0.0f, 0.0f};
@@ -480,11 +1094,76 @@ int main()
     glm::vec3 sphere_position{0.0f, 0.5f, 0.0f};
     glm::vec3 sphere_scale{20.0f, 20.0f, 20.0f};
 
+    // Commands
+
+    // The plane and the sphere never change, so they are recorded once.
+    // Every light is a separate partition recorded each frame on the
+    // recording threads: its parameters go before the scene, its marker after.
+    // Per-frame commands live in the frame arena and recording them must not
+    // touch the heap once the first few frames have passed.
+
+    FrameArena static_arena{STATIC_ARENA_CAPACITY};
+    FrameArena frame_arena{FRAME_ARENA_CAPACITY};
+
+    TransformCache transforms;
+    auto plane_transform = transforms.add(plane_position, plane_rotation, glm::vec3{1.0f});
+    auto sphere_transform = transforms.add(sphere_position, glm::vec3{0.0f}, sphere_scale);
+
+    CommandBuffer scene_commands{static_arena};
+    scene_commands.set_parameter("material_emission_color", glm::vec4{0.0f, 0.0f, 0.0f, 0.0f});
+    scene_commands.set_parameter("point_light_enabled", true);
+    scene_commands.set_model_transform(plane_transform);
+    scene_commands.set_geometry(plane_drawable);
+    scene_commands.draw();
+    scene_commands.set_model_transform(sphere_transform);
+    scene_commands.set_geometry(sphere_drawable);
+    scene_commands.draw();
+
+    struct LightPartition {
+        const char* view_position_parameter;
+        const char* enabled_parameter;
+        float height;
+        float orbit_radius;
+        float* orbit_angle;
+        float orbit_delta_angle;
+        float* intensity;
+        glm::vec3 diffuse_color;
+        TransformCache::object_type marker_transform;
+        CommandBuffer parameter_commands;
+        CommandBuffer marker_commands;
+    };
+    std::array<LightPartition, 2> light_partitions{{
+        {
+            "point_light_view_position", "point_light_enabled",
+            point_light1_height, point_light1_orbit_radius, &point_light1_orbit_angle, point_light1_orbit_delta_angle,
+            &point_light1_intensity, point_light1_diffuse_color,
+            transforms.add(glm::vec3{0.0f}, glm::vec3{0.0f}, glm::vec3{1.0f}),
+            CommandBuffer{frame_arena}, CommandBuffer{frame_arena}
+        },
+        {
+            "point_light2_view_position", "point_light2_enabled",
+            point_light2_height, point_light2_orbit_radius, &point_light2_orbit_angle, point_light2_orbit_delta_angle,
+            &point_light2_intensity, point_light2_diffuse_color,
+            transforms.add(glm::vec3{0.0f}, glm::vec3{0.0f}, glm::vec3{1.0f}),
+            CommandBuffer{frame_arena}, CommandBuffer{frame_arena}
+        }
+    }};
+
+    CommandRecorders command_recorders(static_cast<unsigned int>(light_partitions.size()) - 1U);
+
+    // Statistics of the light parameters, the scene and the light markers.
+    static const std::array<const char*, STATISTICS_PASS_COUNT> STATISTICS_PASS_NAMES{"lights", "scene", "markers"};
+    std::array<RenderStatistics, STATISTICS_PASS_COUNT> pass_statistics{};
+    RenderStatistics frame_statistics{};
+    int exit_code{0};
+
+    unsigned int frame{0};
     bool should_stop{false};
     while (!should_stop) {
         process_window_events(&should_stop);
 
         prepare_to_render_frame();
+        frame_arena.reset();
 
         // Camera
 
@@ -492,79 +1171,98 @@ int main()
         load_identity_matrix();
         translate_matrix(camera_position);
         rotate_matrix(camera_rotation);
+        if (camera_position != versioned_camera_position || camera_rotation != versioned_camera_rotation) {
+            versioned_camera_position = camera_position;
+            versioned_camera_rotation = camera_rotation;
+            ++camera_version;
+        }
 
-        // Material
-
-        // Light 1
-        glm::vec3 point_light1_position{
-            std::cos(point_light1_orbit_angle) * point_light1_orbit_radius,
-            point_light1_height,
-            std::sin(point_light1_orbit_angle) * point_light1_orbit_radius
-        };
-        set_material_parameter("point_light_view_position", (get_view_matrix_inverted() * glm::vec4{ point_light1_position, 1.0f}).xyz());
-        point_light1_orbit_angle += point_light1_orbit_delta_angle;
-
-        point_light1_intensity = point_light_intensity_min + ((std::sinf(point_light_intensity_angle) + 1.0f) * 0.5f) * (point_light_intensity_max - point_light_intensity_min);        
+        // Lights
 
-        // Light 2
-        glm::vec3 point_light2_position{
-           std::cos(point_light2_orbit_angle) * point_light2_orbit_radius,
-           point_light2_height,
-           std::sin(point_light2_orbit_angle) * point_light2_orbit_radius
+        if (view_matrix_inverted_version != camera_version) {
+            view_matrix_inverted = get_view_matrix_inverted();
+            view_matrix_inverted_version = camera_version;
+        }
+        float light_intensity =
+            point_light_intensity_min + ((std::sinf(point_light_intensity_angle) + 1.0f) * 0.5f) * (point_light_intensity_max - point_light_intensity_min);
+
+        auto record_light = [&](unsigned int partition) {
+            auto& light = light_partitions[partition];
+
+            glm::vec3 light_position{
+                std::cos(*light.orbit_angle) * light.orbit_radius,
+                light.height,
+                std::sin(*light.orbit_angle) * light.orbit_radius
+            };
+            *light.orbit_angle += light.orbit_delta_angle;
+            *light.intensity = light_intensity;
+
+            light.parameter_commands.clear();
+            light.parameter_commands.set_parameter(light.view_position_parameter, (view_matrix_inverted * glm::vec4{light_position, 1.0f}).xyz());
+
+            light.marker_commands.clear();
+            light.marker_commands.set_parameter(light.enabled_parameter, true);
+            light.marker_commands.set_parameter("material_emission_color", glm::vec4{light.diffuse_color, 1.0f});
+            transforms.set(light.marker_transform, light_position, glm::vec3{0.0f}, glm::vec3{1.0f});
+            light.marker_commands.set_model_transform(light.marker_transform);
+            light.marker_commands.set_geometry(sphere_drawable);
+            light.marker_commands.draw();
         };
-        set_material_parameter("point_light2_view_position", (get_view_matrix_inverted() * glm::vec4{ point_light2_position, 1.0f }).xyz());
-        point_light2_orbit_angle += point_light2_orbit_delta_angle;
-
-        point_light2_intensity = point_light_intensity_min + ((std::sinf(point_light_intensity_angle) + 1.0f) * 0.5f) * (point_light_intensity_max - point_light_intensity_min);
+        size_t allocation_count{Allocation_Count};
+        command_recorders.record(static_cast<unsigned int>(light_partitions.size()), record_light);
+        size_t recording_allocations{Allocation_Count - allocation_count};
+        if (frame >= ALLOCATION_CHECK_WARM_UP_FRAMES && recording_allocations != 0) {
+            std::fprintf(stderr, "Frame %u: recording made %zu heap allocations, none allowed\n", frame, recording_allocations);
+            exit_code = 1;
+            should_stop = true;
+        }
+        ++frame;
 
         point_light_intensity_angle += point_light_intensity_angle_delta;
 
+        transforms.update(view_matrix_inverted, camera_version);
 
-        // Plane
-
-        set_material_parameter("material_emission_color", glm::vec4{0.0f, 0.0f, 0.0f, 0.0f});
-        set_material_parameter("point_light_enabled", true);
-
-        set_matrix_mode(Model);
-        load_identity_matrix();
-        translate_matrix(plane_position);
-        rotate_matrix(plane_rotation);
-
-        set_geometry_current(&plane_geometry);
-        render_current_geometry();
-
-        // Sphere
-
-        load_identity_matrix();
-        translate_matrix(sphere_position);
-        scale_matrix(sphere_scale);
-
-        set_geometry_current(&sphere_geometry);
-        render_current_geometry();
-
-        // Light 1
+        // Replay
 
-        set_material_parameter("point_light_enabled", true);
-        set_material_parameter("material_emission_color", glm::vec4{ point_light1_diffuse_color, 1.0f});
-
-        load_identity_matrix();
-        translate_matrix(point_light1_position);
-
-        set_geometry_current(&sphere_geometry);
-        render_current_geometry();
-
-        // Light 2
+        pass_statistics.fill(RenderStatistics{});
+        for (auto& light : light_partitions) {
+            light.parameter_commands.replay(transforms, &pass_statistics[0]);
+        }
+        scene_commands.replay(transforms, &pass_statistics[1]);
+        for (auto& light : light_partitions) {
+            light.marker_commands.replay(transforms, &pass_statistics[2]);
+        }
 
-        set_material_parameter("point_light2_enabled", true);
-        set_material_parameter("material_emission_color", glm::vec4{ point_light2_diffuse_color, 1.0f });
+        finish_frame_rendering();
 
-        load_identity_matrix();
-        translate_matrix(point_light2_position);
+        // Statistics
 
-        set_geometry_current(&sphere_geometry);
-        render_current_geometry();
+        frame_statistics = RenderStatistics{};
+        for (auto pass = 0U; pass < STATISTICS_PASS_COUNT; ++pass) {
+            frame_statistics += pass_statistics[pass];
+            if (statistics_output.is_open()) {
+                write_statistics_csv_row(statistics_output, frame, STATISTICS_PASS_NAMES[pass], pass_statistics[pass]);
+            }
+        }
 
-        finish_frame_rendering();
+        auto over_budget = [](const char* name, unsigned int value, unsigned int limit) {
+            if (limit != 0 && value > limit) {
+                std::fprintf(stderr, "Frame budget exceeded: %u %s, at most %u allowed\n", value, name, limit);
+                return true;
+            }
+            return false;
+        };
+        bool exceeded = over_budget("draw calls", frame_statistics.draw_calls, budget.draw_calls);
+        exceeded = over_budget("triangles", frame_statistics.triangles, budget.triangles) || exceeded;
+        exceeded = over_budget("vertices", frame_statistics.vertices, budget.vertices) || exceeded;
+        exceeded = over_budget("uniform uploads", frame_statistics.uniform_uploads, budget.uniform_uploads) || exceeded;
+        if (exceeded) {
+            exit_code = 1;
+            should_stop = true;
+        }
+        if (frame_limit != 0 && frame >= frame_limit) {
+            should_stop = true;
+        }
     }
 
     destroy_geometry(sphere_geometry);
@@ -574,5 +1272,5 @@ int main()
 
     destroy_window();
 
-    return 0;
+    return exit_code;
 }
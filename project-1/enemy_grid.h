@@ -0,0 +1,338 @@
+#ifndef ENEMY_GRID_H
+#define ENEMY_GRID_H
+
+#include "asr.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define ENEMY_GRID_SSE 1
+    #include <emmintrin.h>
+#else
+    #define ENEMY_GRID_SSE 0
+#endif
+
+// Ray versus packed spheres. Centers and radii are stored as separate
+// arrays so four spheres are tested per SSE instruction. The kernel expects
+// a normalized direction, reports distances along the ray and counts a ray
+// starting inside a sphere as hitting its far side.
+
+static const float NO_HIT{ std::numeric_limits<float>::max() };
+
+[[nodiscard]] inline std::pair<int, float> ray_intersects_with_spheres(
+    const glm::vec3& origin, const glm::vec3& direction,
+    const float* centers_x, const float* centers_y, const float* centers_z, const float* radii,
+    size_t count
+)
+{
+    int closest_index{ -1 };
+    float closest_distance{ NO_HIT };
+    size_t i{ 0 };
+
+#if ENEMY_GRID_SSE
+    __m128 origin_x = _mm_set1_ps(origin.x), origin_y = _mm_set1_ps(origin.y), origin_z = _mm_set1_ps(origin.z);
+    __m128 direction_x = _mm_set1_ps(direction.x), direction_y = _mm_set1_ps(direction.y), direction_z = _mm_set1_ps(direction.z);
+    __m128 zero = _mm_setzero_ps();
+    __m128 best_distances = _mm_set1_ps(NO_HIT);
+    __m128i best_indices = _mm_set1_epi32(-1);
+    __m128i indices = _mm_setr_epi32(0, 1, 2, 3);
+    __m128i index_step = _mm_set1_epi32(4);
+
+    for (; i + 4 <= count; i += 4) {
+        __m128 offset_x = _mm_sub_ps(origin_x, _mm_loadu_ps(centers_x + i));
+        __m128 offset_y = _mm_sub_ps(origin_y, _mm_loadu_ps(centers_y + i));
+        __m128 offset_z = _mm_sub_ps(origin_z, _mm_loadu_ps(centers_z + i));
+        __m128 radius = _mm_loadu_ps(radii + i);
+
+        __m128 b = _mm_add_ps(_mm_add_ps(_mm_mul_ps(offset_x, direction_x), _mm_mul_ps(offset_y, direction_y)), _mm_mul_ps(offset_z, direction_z));
+        __m128 c = _mm_sub_ps(
+            _mm_add_ps(_mm_add_ps(_mm_mul_ps(offset_x, offset_x), _mm_mul_ps(offset_y, offset_y)), _mm_mul_ps(offset_z, offset_z)),
+            _mm_mul_ps(radius, radius)
+        );
+        __m128 discriminant = _mm_sub_ps(_mm_mul_ps(b, b), c);
+        __m128 root = _mm_sqrt_ps(_mm_max_ps(discriminant, zero));
+
+        __m128 near_distance = _mm_sub_ps(_mm_sub_ps(zero, b), root);
+        __m128 far_distance = _mm_add_ps(_mm_sub_ps(zero, b), root);
+        __m128 inside = _mm_cmplt_ps(near_distance, zero);
+        __m128 distance = _mm_or_ps(_mm_and_ps(inside, far_distance), _mm_andnot_ps(inside, near_distance));
+
+        __m128 hit = _mm_and_ps(_mm_cmpge_ps(discriminant, zero), _mm_cmpge_ps(distance, zero));
+        __m128 closer = _mm_and_ps(hit, _mm_cmplt_ps(distance, best_distances));
+
+        best_distances = _mm_or_ps(_mm_and_ps(closer, distance), _mm_andnot_ps(closer, best_distances));
+        __m128i closer_mask = _mm_castps_si128(closer);
+        best_indices = _mm_or_si128(_mm_and_si128(closer_mask, indices), _mm_andnot_si128(closer_mask, best_indices));
+        indices = _mm_add_epi32(indices, index_step);
+    }
+
+    alignas(16) float lane_distances[4];
+    alignas(16) int lane_indices[4];
+    _mm_store_ps(lane_distances, best_distances);
+    _mm_store_si128(reinterpret_cast<__m128i*>(lane_indices), best_indices);
+    for (auto lane = 0; lane < 4; ++lane) {
+        if (lane_indices[lane] >= 0 && lane_distances[lane] < closest_distance) {
+            closest_distance = lane_distances[lane];
+            closest_index = lane_indices[lane];
+        }
+    }
+#endif
+
+    for (; i < count; ++i) {
+        glm::vec3 offset{ origin.x - centers_x[i], origin.y - centers_y[i], origin.z - centers_z[i] };
+        float b = glm::dot(offset, direction);
+        float c = glm::dot(offset, offset) - radii[i] * radii[i];
+        float discriminant = b * b - c;
+        if (discriminant < 0.0f) {
+            continue;
+        }
+
+        float root = std::sqrt(discriminant);
+        float distance = -b - root < 0.0f ? -b + root : -b - root;
+        if (distance >= 0.0f && distance < closest_distance) {
+            closest_distance = distance;
+            closest_index = static_cast<int>(i);
+        }
+    }
+
+    return std::make_pair(closest_index, closest_distance);
+}
+
+// Uniform grid over the XZ plane of the level. Bounding spheres are kept in
+// every cell their footprint overlaps, so a ray query only walks the cells
+// under the ray and can stop as soon as the nearest hit lies before the exit
+// of the current cell. Everything is expected to stay inside the bounds,
+// proxies outside of them are clamped into the border cells.
+class EnemyGrid {
+public:
+    EnemyGrid(const glm::vec2& min, const glm::vec2& max, float cell_size)
+        : _min{ min }, _cell_size{ cell_size }
+    {
+        _columns = std::max(static_cast<int>(std::ceil((max.x - min.x) / cell_size)), 1);
+        _rows = std::max(static_cast<int>(std::ceil((max.y - min.y) / cell_size)), 1);
+        _max = _min + glm::vec2{ static_cast<float>(_columns), static_cast<float>(_rows) } * cell_size;
+        _cells.resize(static_cast<size_t>(_columns) * _rows);
+    }
+
+    unsigned int insert(unsigned int owner, const asr::Sphere& volume)
+    {
+        Proxy proxy;
+        proxy.owner = owner;
+        proxy.volume = volume;
+        proxy.cells = _cell_range(volume);
+
+        unsigned int id = static_cast<unsigned int>(_proxies.size());
+        _proxies.push_back(proxy);
+        _add_to_cells(id, proxy.cells);
+
+        return id;
+    }
+
+    void move(unsigned int id, const asr::Sphere& volume)
+    {
+        auto& proxy = _proxies[id];
+        proxy.volume = volume;
+        if (!proxy.active) {
+            return;
+        }
+
+        glm::ivec4 cells = _cell_range(volume);
+        if (cells != proxy.cells) {
+            _remove_from_cells(id, proxy.cells);
+            _add_to_cells(id, cells);
+            proxy.cells = cells;
+        } else {
+            _update_in_cells(id, cells);
+        }
+    }
+
+    void remove(unsigned int id)
+    {
+        auto& proxy = _proxies[id];
+        if (proxy.active) {
+            _remove_from_cells(id, proxy.cells);
+            proxy.active = false;
+        }
+    }
+
+    // Returns the owner of the nearest sphere hit by the ray or -1.
+    [[nodiscard]] int closest_hit(const asr::Ray& ray) const
+    {
+        return closest_hit(ray.get_origin(), ray.get_direction());
+    }
+
+    [[nodiscard]] int closest_hit(const glm::vec3& origin, const glm::vec3& ray_direction) const
+    {
+        glm::vec3 direction = glm::normalize(ray_direction);
+
+        // Clip the ray against the grid bounds in XZ.
+        float t_min{ 0.0f }, t_max{ std::numeric_limits<float>::max() };
+        float origins[2]{ origin.x, origin.z }, directions[2]{ direction.x, direction.z };
+        float mins[2]{ _min.x, _min.y }, maxs[2]{ _max.x, _max.y };
+        for (auto axis = 0; axis < 2; ++axis) {
+            if (std::abs(directions[axis]) < 1e-8f) {
+                if (origins[axis] < mins[axis] || origins[axis] > maxs[axis]) {
+                    return -1;
+                }
+                continue;
+            }
+            float t0 = (mins[axis] - origins[axis]) / directions[axis];
+            float t1 = (maxs[axis] - origins[axis]) / directions[axis];
+            t_min = std::max(t_min, std::min(t0, t1));
+            t_max = std::min(t_max, std::max(t0, t1));
+        }
+        if (t_min > t_max) {
+            return -1;
+        }
+
+        int closest{ -1 };
+        float closest_distance{ std::numeric_limits<float>::max() };
+
+        glm::vec2 entry{ origins[0] + directions[0] * t_min, origins[1] + directions[1] * t_min };
+        int cell[2]{ _clamp_column(entry.x), _clamp_row(entry.y) };
+        int steps[2]{ directions[0] >= 0.0f ? 1 : -1, directions[1] >= 0.0f ? 1 : -1 };
+        float t_next[2], t_delta[2];
+        for (auto axis = 0; axis < 2; ++axis) {
+            if (std::abs(directions[axis]) < 1e-8f) {
+                t_next[axis] = std::numeric_limits<float>::max();
+                t_delta[axis] = std::numeric_limits<float>::max();
+                continue;
+            }
+            float boundary = mins[axis] + static_cast<float>(cell[axis] + (steps[axis] > 0 ? 1 : 0)) * _cell_size;
+            t_next[axis] = (boundary - origins[axis]) / directions[axis];
+            t_delta[axis] = _cell_size / std::abs(directions[axis]);
+        }
+
+        for (;;) {
+            const auto& spheres = _cells[static_cast<size_t>(cell[1]) * _columns + cell[0]];
+            auto [index, distance] = ray_intersects_with_spheres(
+                origin, direction,
+                spheres.centers_x.data(), spheres.centers_y.data(), spheres.centers_z.data(), spheres.radii.data(),
+                spheres.ids.size()
+            );
+            if (index >= 0 && distance < closest_distance) {
+                closest_distance = distance;
+                closest = static_cast<int>(_proxies[spheres.ids[index]].owner);
+            }
+
+            float t_exit = std::min({ t_next[0], t_next[1], t_max });
+            if (closest_distance <= t_exit || t_exit >= t_max) {
+                break;
+            }
+
+            int axis = t_next[0] < t_next[1] ? 0 : 1;
+            cell[axis] += steps[axis];
+            if (cell[axis] < 0 || cell[axis] >= (axis == 0 ? _columns : _rows)) {
+                break;
+            }
+            t_next[axis] += t_delta[axis];
+        }
+
+        return closest;
+    }
+
+private:
+    struct Proxy {
+        unsigned int owner{ 0 };
+        asr::Sphere volume{ glm::vec3{ 0.0f }, 1.0f };
+        glm::ivec4 cells{ 0 };
+        bool active{ true };
+    };
+
+    struct Cell {
+        std::vector<unsigned int> ids;
+        std::vector<float> centers_x, centers_y, centers_z, radii;
+    };
+
+    glm::vec2 _min, _max;
+    float _cell_size;
+    int _columns, _rows;
+
+    std::vector<Proxy> _proxies;
+    std::vector<Cell> _cells;
+
+    [[nodiscard]] int _clamp_column(float x) const
+    {
+        return std::clamp(static_cast<int>(std::floor((x - _min.x) / _cell_size)), 0, _columns - 1);
+    }
+
+    [[nodiscard]] int _clamp_row(float z) const
+    {
+        return std::clamp(static_cast<int>(std::floor((z - _min.y) / _cell_size)), 0, _rows - 1);
+    }
+
+    [[nodiscard]] glm::ivec4 _cell_range(const asr::Sphere& volume) const
+    {
+        glm::vec3 center = volume.get_center();
+        float radius = volume.get_radius();
+        return glm::ivec4{
+            _clamp_column(center.x - radius), _clamp_row(center.z - radius),
+            _clamp_column(center.x + radius), _clamp_row(center.z + radius)
+        };
+    }
+
+    void _add_to_cells(unsigned int id, const glm::ivec4& cells)
+    {
+        glm::vec3 center = _proxies[id].volume.get_center();
+        float radius = _proxies[id].volume.get_radius();
+        for (auto row = cells.y; row <= cells.w; ++row) {
+            for (auto column = cells.x; column <= cells.z; ++column) {
+                auto& cell = _cells[static_cast<size_t>(row) * _columns + column];
+                cell.ids.push_back(id);
+                cell.centers_x.push_back(center.x);
+                cell.centers_y.push_back(center.y);
+                cell.centers_z.push_back(center.z);
+                cell.radii.push_back(radius);
+            }
+        }
+    }
+
+    void _update_in_cells(unsigned int id, const glm::ivec4& cells)
+    {
+        glm::vec3 center = _proxies[id].volume.get_center();
+        float radius = _proxies[id].volume.get_radius();
+        for (auto row = cells.y; row <= cells.w; ++row) {
+            for (auto column = cells.x; column <= cells.z; ++column) {
+                auto& cell = _cells[static_cast<size_t>(row) * _columns + column];
+                auto position = std::find(cell.ids.begin(), cell.ids.end(), id);
+                if (position != cell.ids.end()) {
+                    size_t i = position - cell.ids.begin();
+                    cell.centers_x[i] = center.x;
+                    cell.centers_y[i] = center.y;
+                    cell.centers_z[i] = center.z;
+                    cell.radii[i] = radius;
+                }
+            }
+        }
+    }
+
+    void _remove_from_cells(unsigned int id, const glm::ivec4& cells)
+    {
+        for (auto row = cells.y; row <= cells.w; ++row) {
+            for (auto column = cells.x; column <= cells.z; ++column) {
+                auto& cell = _cells[static_cast<size_t>(row) * _columns + column];
+                auto position = std::find(cell.ids.begin(), cell.ids.end(), id);
+                if (position != cell.ids.end()) {
+                    size_t i = position - cell.ids.begin();
+                    cell.ids[i] = cell.ids.back();
+                    cell.centers_x[i] = cell.centers_x.back();
+                    cell.centers_y[i] = cell.centers_y.back();
+                    cell.centers_z[i] = cell.centers_z.back();
+                    cell.radii[i] = cell.radii.back();
+                    cell.ids.pop_back();
+                    cell.centers_x.pop_back();
+                    cell.centers_y.pop_back();
+                    cell.centers_z.pop_back();
+                    cell.radii.pop_back();
+                }
+            }
+        }
+    }
+};
+
+#endif
@@ -1,9 +1,43 @@
 #include "asr.h"
+#include "enemy_grid.h"
+#include "job_system.h"
+#include "level_description.h"
+#include "mesh_format.h"
+#include "profiler.h"
+#include "tangent_frames.h"
+#include "../common/fixed_meshes.h"
+#include "../common/transforms.h"
 
 #include <utility>
 #include <memory>
 #include <tuple>
 #include <chrono>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <initializer_list>
+#include <limits>
+#include <mutex>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define GAME_TEST_SSE 1
+    #include <emmintrin.h>
+#else
+    #define GAME_TEST_SSE 0
+#endif
 
 using namespace asr;
 
@@ -12,6 +46,48 @@ static const float CAMERA_SENSITIVITY{ 0.001f };
 static bool GAME_IS_LOST{ false };
 static bool GAME_IS_WON{ true };
 
+static const size_t TEXTURE_STREAMING_BUDGET{ 48U * 1024U * 1024U };
+static const unsigned int TEXTURE_STREAMING_BASE_SIZE{ 64U };
+// A resident level is kept until the texture covers this many times fewer
+// pixels on screen than the next coarser level has, so small camera moves
+// do not swap levels back and forth.
+static const float TEXTURE_STREAMING_HYSTERESIS{ 1.5f };
+static const size_t ENEMY_SYSTEM_PARALLEL_BATCH_SIZE{ 8192U };
+
+static const unsigned int OCCLUSION_BUFFER_WIDTH{ 256U };
+static const unsigned int OCCLUSION_BUFFER_HEIGHT{ 128U };
+static const float OCCLUSION_NEAR_W{ 0.01f };
+
+static const size_t LIGHT_BAKING_BATCH_SIZE{ 512U };
+static const float LIGHT_BAKING_SHADOW_BIAS{ 0.01f };
+
+static const float SIMULATION_STEP{ 1.0f / 60.0f };
+static const unsigned int SIMULATION_MAX_STEPS_PER_FRAME{ 8U };
+
+static constexpr auto SPRITE_QUAD_MESH{ fixed_meshes::make_quad(1.0f, 1.0f) };
+static constexpr auto OVERLAY_QUAD_MESH{ fixed_meshes::make_quad(2.0f, 2.0f) };
+static constexpr auto LAMP_MESH{ fixed_meshes::make_sphere<20, 20>(0.2f) };
+
+// Copies a mesh the compiler generated into the (indices, vertices) pair
+// the geometry generators return. Only the conversion runs at startup.
+template<size_t VertexCount, size_t IndexCount>
+[[nodiscard]] static std::pair<std::vector<unsigned int>, std::vector<Vertex>> copy_fixed_mesh(
+    const fixed_meshes::FixedMesh<VertexCount, IndexCount>& mesh
+)
+{
+    std::vector<Vertex> vertices(VertexCount);
+    for (size_t i = 0; i < VertexCount; ++i) {
+        const auto& fixed_vertex = mesh.vertices[i];
+        auto& vertex = vertices[i];
+        vertex.position = glm::vec3{ fixed_vertex.position[0], fixed_vertex.position[1], fixed_vertex.position[2] };
+        vertex.normal = glm::vec3{ fixed_vertex.normal[0], fixed_vertex.normal[1], fixed_vertex.normal[2] };
+        vertex.color = glm::vec4{ 1.0f };
+        vertex.texture_coordinates = glm::vec2{ fixed_vertex.texture_coordinates[0], fixed_vertex.texture_coordinates[1] };
+    }
+
+    return std::make_pair(std::vector<unsigned int>(mesh.indices.begin(), mesh.indices.end()), std::move(vertices));
+}
+
 [[noreturn]]
 void showMessage(char* msg)
 {
@@ -21,164 +97,1382 @@ void showMessage(char* msg)
     ImGui::End();
 };
 
-class Enemy {
+// The matrices of a camera and their inverses, computed again only after
+// the camera has changed. The camera is moved and zoomed through this class
+// so every change marks them dirty; reading them otherwise costs nothing.
+// Screen points are in pixels from the top left corner of the viewport.
+class CameraMatrices {
 public:
-    typedef std::tuple<const std::string, unsigned int, unsigned int> enemy_sprite_data_type;
+    CameraMatrices(std::shared_ptr<Camera> camera, float viewport_width, float viewport_height) :
+        _camera{ std::move(camera) },
+        _viewport_width{ viewport_width },
+        _viewport_height{ viewport_height }
+    { }
 
-    enum State {
-        Alive,
-        Dying,
-        Dead
+    [[nodiscard]] const std::shared_ptr<Camera>& get_camera() const
+    {
+        return _camera;
+    }
+
+    void set_position(const glm::vec3& position)
+    {
+        _camera->set_position(position);
+        _dirty = true;
+    }
+
+    void add_to_position(const glm::vec3& offset)
+    {
+        _camera->add_to_position(offset);
+        _dirty = true;
+    }
+
+    void add_to_rotation_y(float angle)
+    {
+        _camera->add_to_rotation_y(angle);
+        _dirty = true;
+    }
+
+    void set_zoom(float zoom)
+    {
+        _camera->set_zoom(zoom);
+        _dirty = true;
+    }
+
+    void set_viewport_size(float viewport_width, float viewport_height)
+    {
+        if (viewport_width != _viewport_width || viewport_height != _viewport_height) {
+            _viewport_width = viewport_width;
+            _viewport_height = viewport_height;
+            _dirty = true;
+        }
+    }
+
+    [[nodiscard]] const glm::vec3& get_world_position()
+    {
+        _update();
+        return _world_position;
+    }
+
+    // The transformation of the camera itself, the inverse of the view matrix.
+    [[nodiscard]] const glm::mat4& get_model_matrix()
+    {
+        _update();
+        return _model_matrix;
+    }
+
+    [[nodiscard]] const glm::mat4& get_view_matrix()
+    {
+        _update();
+        return _view_matrix;
+    }
+
+    [[nodiscard]] const glm::mat4& get_projection_matrix()
+    {
+        _update();
+        return _projection_matrix;
+    }
+
+    [[nodiscard]] const glm::mat4& get_view_projection_matrix()
+    {
+        _update();
+        return _view_projection_matrix;
+    }
+
+    [[nodiscard]] const glm::mat4& get_projection_matrix_inverted()
+    {
+        _update();
+        return _projection_matrix_inverted;
+    }
+
+    [[nodiscard]] const glm::mat4& get_view_projection_matrix_inverted()
+    {
+        _update();
+        return _view_projection_matrix_inverted;
+    }
+
+    // Rays from the camera through every screen point, with normalized
+    // directions. Every point costs one matrix-vector product with the cached
+    // inverse; no matrix is inverted here.
+    void world_rays_from_screen_points(const glm::vec2* points, size_t count, glm::vec3* origins, glm::vec3* directions)
+    {
+        _update();
+
+        float x_scale{ 2.0f / _viewport_width }, y_scale{ 2.0f / _viewport_height };
+        for (size_t i = 0; i < count; ++i) {
+            glm::vec4 far_point = _view_projection_matrix_inverted * glm::vec4{
+                points[i].x * x_scale - 1.0f, 1.0f - points[i].y * y_scale, 1.0f, 1.0f
+            };
+            origins[i] = _world_position;
+            directions[i] = glm::normalize(glm::vec3(far_point) / far_point.w - _world_position);
+        }
+    }
+
+    void world_ray_from_screen_point(const glm::vec2& point, glm::vec3& origin, glm::vec3& direction)
+    {
+        world_rays_from_screen_points(&point, 1, &origin, &direction);
+    }
+
+private:
+    std::shared_ptr<Camera> _camera;
+    float _viewport_width, _viewport_height;
+
+    bool _dirty{ true };
+    glm::vec3 _world_position{ 0.0f };
+    glm::mat4 _model_matrix{ 1.0f }, _view_matrix{ 1.0f }, _projection_matrix{ 1.0f }, _view_projection_matrix{ 1.0f };
+    glm::mat4 _projection_matrix_inverted{ 1.0f }, _view_projection_matrix_inverted{ 1.0f };
+
+    void _update()
+    {
+        if (!_dirty) {
+            return;
+        }
+        _dirty = false;
+
+        _world_position = _camera->get_world_position();
+        _model_matrix = _camera->get_model_matrix();
+        _view_matrix = glm::inverse(_model_matrix);
+        _projection_matrix = _camera->get_projection_matrix();
+        _view_projection_matrix = _projection_matrix * _view_matrix;
+        _projection_matrix_inverted = glm::inverse(_projection_matrix);
+        _view_projection_matrix_inverted = _model_matrix * _projection_matrix_inverted;
+    }
+};
+
+class TextureStreamer {
+public:
+    typedef std::function<void(const std::shared_ptr<ES2Texture>&)> texture_binder_type;
+    typedef decltype(file_utilities::read_image_file(std::string{})) image_data_type;
+
+    struct Statistics {
+        size_t budget_bytes{ 0 };
+        size_t resident_bytes{ 0 };
+        size_t wanted_bytes{ 0 };
+        unsigned int textures{ 0 };
+        unsigned int pending_loads{ 0 };
+        unsigned int uploads{ 0 };
+        unsigned int evictions{ 0 };
+    };
+
+    explicit TextureStreamer(size_t budget_bytes) : _budget_bytes{ budget_bytes }
+    {
+        _loader = std::thread([this] { _run_loader(); });
+    }
+
+    ~TextureStreamer()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stopping = true;
+        }
+        _requests_changed.notify_all();
+        _loader.join();
+    }
+
+    TextureStreamer(const TextureStreamer&) = delete;
+    TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+    // Reads the image once to learn its size and keeps only a small base level resident.
+    // The binder is called every time a different mip level becomes resident.
+    unsigned int add_texture(const std::string& file, const texture_binder_type& binder)
+    {
+        return add_texture(file, file_utilities::read_image_file(file), binder);
+    }
+
+    // Same with the image already decoded, e.g. on a loading thread.
+    unsigned int add_texture(const std::string& file, const image_data_type& image, const texture_binder_type& binder)
+    {
+        const auto& [image_data, image_width, image_height, image_channels] = image;
+
+        StreamedTexture texture;
+        texture.file = file;
+        texture.width = static_cast<unsigned int>(image_width);
+        texture.height = static_cast<unsigned int>(image_height);
+        texture.channels = static_cast<unsigned int>(image_channels);
+        texture.binder = binder;
+
+        texture.base_level = 0;
+        while ((std::max(texture.width, texture.height) >> texture.base_level) > TEXTURE_STREAMING_BASE_SIZE) {
+            ++texture.base_level;
+        }
+
+        std::vector<uint8_t> pixels(image_data.begin(), image_data.end());
+        unsigned int width{ texture.width }, height{ texture.height };
+        for (auto level = 0U; level < texture.base_level; ++level) {
+            pixels = _downsample(pixels, width, height, texture.channels);
+        }
+        texture.base_pixels = std::move(pixels);
+
+        texture.resident_level = texture.base_level;
+        texture.wanted_level = texture.base_level;
+        texture.requested_level = texture.base_level;
+
+        unsigned int handle = static_cast<unsigned int>(_textures.size());
+        _textures.push_back(std::move(texture));
+        _upload_base_level(_textures.back());
+
+        return handle;
+    }
+
+    // A mesh is sampled with this texture and covers roughly a sphere of the given radius.
+    void add_user(unsigned int handle, const std::shared_ptr<Mesh>& mesh, float radius)
+    {
+        add_user(handle, mesh, glm::vec3{ 0.0f }, radius);
+    }
+
+    // Same for a part of a mesh, e.g. one object of a static batch, whose sphere
+    // is centered at the given offset from the mesh position.
+    void add_user(unsigned int handle, const std::shared_ptr<Mesh>& mesh, const glm::vec3& offset, float radius)
+    {
+        _textures[handle].users.push_back(TextureUser{ mesh, offset, radius });
+    }
+
+    void update(CameraMatrices& camera, float viewport_height)
+    {
+        _statistics = Statistics{};
+        _statistics.budget_bytes = _budget_bytes;
+        _statistics.textures = static_cast<unsigned int>(_textures.size());
+
+        _apply_completed_loads();
+
+        glm::vec3 camera_position = camera.get_world_position();
+        float pixels_per_unit = camera.get_projection_matrix()[1][1] * viewport_height * 0.5f;
+
+        for (auto& texture : _textures) {
+            float wanted_pixels{ 0.0f };
+            for (auto& [mesh, offset, radius] : texture.users) {
+                float distance = glm::length(mesh->get_position() + offset - camera_position) - radius;
+                if (distance <= 0.0f) {
+                    wanted_pixels = std::numeric_limits<float>::max();
+                    break;
+                }
+                wanted_pixels = std::max(wanted_pixels, radius * 2.0f * pixels_per_unit / distance);
+            }
+            texture.wanted_level = _level_for_pixels(texture, wanted_pixels);
+            if (texture.wanted_level > texture.resident_level &&
+                _level_for_pixels(texture, wanted_pixels * TEXTURE_STREAMING_HYSTERESIS) <= texture.resident_level) {
+                texture.wanted_level = texture.resident_level;
+            }
+            texture.wanted_pixels = wanted_pixels;
+        }
+
+        _fit_into_budget();
+
+        std::vector<LoadRequest> requests;
+        for (auto handle = 0U; handle < _textures.size(); ++handle) {
+            auto& texture = _textures[handle];
+
+            // A texture that should get coarser keeps its finer level until
+            // the wanted one is loaded, only the base level is at hand.
+            if (texture.wanted_level == texture.resident_level) {
+                texture.requested_level = texture.resident_level;
+            } else if (texture.wanted_level != texture.requested_level) {
+                texture.requested_level = texture.wanted_level;
+                if (texture.wanted_level == texture.base_level) {
+                    _upload_base_level(texture);
+                    ++_statistics.evictions;
+                } else {
+                    requests.push_back(LoadRequest{ handle, texture.file, texture.wanted_level });
+                }
+            }
+
+            _statistics.resident_bytes += _level_bytes(texture, texture.resident_level);
+            _statistics.wanted_bytes += _level_bytes(texture, texture.wanted_level);
+        }
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!requests.empty()) {
+            _requests.insert(_requests.end(), requests.begin(), requests.end());
+            _requests_changed.notify_one();
+        }
+        _statistics.pending_loads = static_cast<unsigned int>(_requests.size() + _loads_in_flight);
+    }
+
+    [[nodiscard]] const Statistics& get_statistics() const
+    {
+        return _statistics;
+    }
+
+private:
+    struct TextureUser {
+        std::shared_ptr<Mesh> mesh;
+        glm::vec3 offset;
+        float radius;
+    };
+
+    struct StreamedTexture {
+        std::string file;
+        unsigned int width{ 0 }, height{ 0 }, channels{ 0 };
+        unsigned int base_level{ 0 };
+        unsigned int resident_level{ 0 };
+        unsigned int wanted_level{ 0 };
+        unsigned int requested_level{ 0 };
+        float wanted_pixels{ 0.0f };
+        std::vector<uint8_t> base_pixels;
+        std::shared_ptr<ES2Texture> texture;
+        texture_binder_type binder;
+        std::vector<TextureUser> users;
+    };
+
+    struct LoadRequest {
+        unsigned int handle;
+        std::string file;
+        unsigned int level;
+    };
+
+    struct CompletedLoad {
+        unsigned int handle;
+        unsigned int level;
+        unsigned int width, height;
+        std::vector<uint8_t> pixels;
+    };
+
+    size_t _budget_bytes;
+    Statistics _statistics;
+    std::vector<StreamedTexture> _textures;
+
+    std::thread _loader;
+    std::mutex _mutex;
+    std::condition_variable _requests_changed;
+    std::deque<LoadRequest> _requests;
+    std::vector<CompletedLoad> _completed_loads;
+    unsigned int _loads_in_flight{ 0 };
+    bool _stopping{ false };
+
+    [[nodiscard]] static size_t _level_bytes(const StreamedTexture& texture, unsigned int level)
+    {
+        size_t width = std::max(texture.width >> level, 1U);
+        size_t height = std::max(texture.height >> level, 1U);
+        return width * height * texture.channels;
+    }
+
+    // The finest level needed to cover the given number of pixels on screen.
+    [[nodiscard]] static unsigned int _level_for_pixels(const StreamedTexture& texture, float pixels)
+    {
+        unsigned int level{ texture.base_level };
+        while (level > 0 && static_cast<float>(std::max(texture.width, texture.height) >> level) < pixels) {
+            --level;
+        }
+
+        return level;
+    }
+
+    [[nodiscard]] static std::vector<uint8_t> _downsample(
+        const std::vector<uint8_t>& pixels, unsigned int& width, unsigned int& height, unsigned int channels
+    )
+    {
+        unsigned int next_width = std::max(width / 2U, 1U);
+        unsigned int next_height = std::max(height / 2U, 1U);
+
+        std::vector<uint8_t> result(static_cast<size_t>(next_width) * next_height * channels);
+        for (auto y = 0U; y < next_height; ++y) {
+            unsigned int y0 = std::min(y * 2U, height - 1U), y1 = std::min(y * 2U + 1U, height - 1U);
+            for (auto x = 0U; x < next_width; ++x) {
+                unsigned int x0 = std::min(x * 2U, width - 1U), x1 = std::min(x * 2U + 1U, width - 1U);
+                for (auto c = 0U; c < channels; ++c) {
+                    unsigned int sum =
+                        pixels[(static_cast<size_t>(y0) * width + x0) * channels + c] +
+                        pixels[(static_cast<size_t>(y0) * width + x1) * channels + c] +
+                        pixels[(static_cast<size_t>(y1) * width + x0) * channels + c] +
+                        pixels[(static_cast<size_t>(y1) * width + x1) * channels + c];
+                    result[(static_cast<size_t>(y) * next_width + x) * channels + c] = static_cast<uint8_t>((sum + 2U) / 4U);
+                }
+            }
+        }
+
+        width = next_width;
+        height = next_height;
+
+        return result;
+    }
+
+    void _upload_base_level(StreamedTexture& texture)
+    {
+        unsigned int width = std::max(texture.width >> texture.base_level, 1U);
+        unsigned int height = std::max(texture.height >> texture.base_level, 1U);
+        texture.texture = std::make_shared<ES2Texture>(texture.base_pixels, width, height, texture.channels);
+        texture.resident_level = texture.base_level;
+        texture.binder(texture.texture);
+    }
+
+    // Coarsens the textures that cover the fewest pixels on screen first until the wanted set fits.
+    void _fit_into_budget()
+    {
+        std::vector<StreamedTexture*> textures;
+        size_t wanted_bytes{ 0 };
+        for (auto& texture : _textures) {
+            textures.push_back(&texture);
+            wanted_bytes += _level_bytes(texture, texture.wanted_level);
+        }
+        std::sort(textures.begin(), textures.end(), [](const StreamedTexture* a, const StreamedTexture* b) {
+            return a->wanted_pixels < b->wanted_pixels;
+        });
+
+        bool coarsened{ true };
+        while (wanted_bytes > _budget_bytes && coarsened) {
+            coarsened = false;
+            for (auto* texture : textures) {
+                if (wanted_bytes <= _budget_bytes) {
+                    break;
+                }
+                if (texture->wanted_level < texture->base_level) {
+                    wanted_bytes -= _level_bytes(*texture, texture->wanted_level);
+                    ++texture->wanted_level;
+                    wanted_bytes += _level_bytes(*texture, texture->wanted_level);
+                    coarsened = true;
+                }
+            }
+        }
+    }
+
+    void _apply_completed_loads()
+    {
+        std::vector<CompletedLoad> completed_loads;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            completed_loads.swap(_completed_loads);
+        }
+
+        for (auto& load : completed_loads) {
+            auto& texture = _textures[load.handle];
+            if (load.level != texture.requested_level || load.level == texture.resident_level) {
+                continue;
+            }
+
+            if (load.level > texture.resident_level) {
+                ++_statistics.evictions;
+            }
+            texture.texture = std::make_shared<ES2Texture>(load.pixels, load.width, load.height, texture.channels);
+            texture.resident_level = load.level;
+            texture.binder(texture.texture);
+            ++_statistics.uploads;
+        }
+    }
+
+    void _run_loader()
+    {
+        for (;;) {
+            LoadRequest request;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _requests_changed.wait(lock, [this] { return _stopping || !_requests.empty(); });
+                if (_stopping) {
+                    return;
+                }
+                request = std::move(_requests.front());
+                _requests.pop_front();
+                ++_loads_in_flight;
+            }
+            PROFILE_ZONE("texture load");
+
+            auto [image_data, image_width, image_height, image_channels] = file_utilities::read_image_file(request.file);
+            std::vector<uint8_t> pixels(image_data.begin(), image_data.end());
+            auto width = static_cast<unsigned int>(image_width);
+            auto height = static_cast<unsigned int>(image_height);
+            for (auto level = 0U; level < request.level; ++level) {
+                pixels = _downsample(pixels, width, height, static_cast<unsigned int>(image_channels));
+            }
+
+            std::lock_guard<std::mutex> lock(_mutex);
+            _completed_loads.push_back(CompletedLoad{ request.handle, request.level, width, height, std::move(pixels) });
+            --_loads_in_flight;
+        }
+    }
+};
+
+// Planes of the view frustum of a view projection matrix with the normals
+// pointing inside and normalized, so a plane equation gives the distance.
+[[nodiscard]] static std::array<glm::vec4, 6> extract_frustum_planes(const glm::mat4& view_projection_matrix)
+{
+    glm::mat4 m = glm::transpose(view_projection_matrix);
+    std::array<glm::vec4, 6> planes{
+        m[3] + m[0], m[3] - m[0],
+        m[3] + m[1], m[3] - m[1],
+        m[3] + m[2], m[3] - m[2]
+    };
+    for (auto& plane : planes) {
+        plane /= glm::length(glm::vec3(plane));
+    }
+
+    return planes;
+}
+
+[[nodiscard]] static bool sphere_is_in_frustum(const std::array<glm::vec4, 6>& planes, const glm::vec3& center, float radius)
+{
+    for (const auto& plane : planes) {
+        if (glm::dot(glm::vec3(plane), center) + plane.w < -radius) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Objects that never move and share a material, merged at load time into
+// one geometry with the vertices already in world space, so the whole group
+// is one draw with an identity model matrix. Every object keeps its index
+// range and bounding sphere: cull() leaves out the ranges of objects outside
+// the frustum and updates the index buffer only when that set changes.
+class StaticBatch {
+public:
+    explicit StaticBatch(const std::shared_ptr<Material>& material) : _material{ material }
+    { }
+
+    // Returns the object index. The radius is that of the bounding sphere
+    // around the object origin, in world units.
+    unsigned int add(
+        const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices,
+        const glm::mat4& model_matrix, float radius
+    )
+    {
+        assert(_mesh == nullptr);
+
+        auto first_vertex = static_cast<unsigned int>(_vertices.size());
+        glm::mat3 normal_matrix = glm::transpose(glm::inverse(glm::mat3(model_matrix)));
+        for (auto vertex : vertices) {
+            vertex.position = glm::vec3(model_matrix * glm::vec4(vertex.position, 1.0f));
+            vertex.normal = glm::normalize(normal_matrix * vertex.normal);
+            _vertices.push_back(vertex);
+        }
+
+        StaticObject object;
+        object.first_index = _all_indices.size();
+        object.index_count = indices.size();
+        object.center = glm::vec3(model_matrix[3]);
+        object.radius = radius;
+        for (auto index : indices) {
+            _all_indices.push_back(first_vertex + index);
+        }
+        _objects.push_back(object);
+
+        return static_cast<unsigned int>(_objects.size() - 1);
+    }
+
+    // Creates the merged geometry once all objects are added.
+    void build()
+    {
+        _indices = _all_indices;
+        _geometry = std::make_shared<ES2Geometry>(_indices, _vertices);
+        _mesh = std::make_shared<Mesh>(_geometry, _material);
+    }
+
+    [[nodiscard]] const std::shared_ptr<Mesh>& get_mesh() const
+    {
+        return _mesh;
+    }
+
+    [[nodiscard]] unsigned int get_object_count() const
+    {
+        return static_cast<unsigned int>(_objects.size());
+    }
+
+    [[nodiscard]] unsigned int get_visible_count() const
+    {
+        return _visible_count;
+    }
+
+    [[nodiscard]] glm::vec3 get_object_center(unsigned int object) const
+    {
+        return _objects[object].center;
+    }
+
+    [[nodiscard]] float get_object_radius(unsigned int object) const
+    {
+        return _objects[object].radius;
+    }
+
+    void cull(const glm::mat4& view_projection_matrix)
+    {
+        auto planes = extract_frustum_planes(view_projection_matrix);
+
+        bool changed{ false };
+        _visible_count = 0;
+        for (auto& object : _objects) {
+            bool visible = sphere_is_in_frustum(planes, object.center, object.radius);
+            changed = changed || visible != object.visible;
+            object.visible = visible;
+            _visible_count += visible ? 1U : 0U;
+        }
+        if (!changed) {
+            return;
+        }
+
+        _indices.clear();
+        for (const auto& object : _objects) {
+            if (object.visible) {
+                auto begin = _all_indices.begin() + static_cast<std::ptrdiff_t>(object.first_index);
+                _indices.insert(_indices.end(), begin, begin + static_cast<std::ptrdiff_t>(object.index_count));
+            }
+        }
+        _geometry->set_indices(_indices);
+    }
+
+private:
+    struct StaticObject {
+        size_t first_index{ 0 };
+        size_t index_count{ 0 };
+        glm::vec3 center{ 0.0f };
+        float radius{ 0.0f };
+        bool visible{ true };
+    };
+
+    std::shared_ptr<Material> _material;
+    std::vector<StaticObject> _objects;
+    unsigned int _visible_count{ 0 };
+
+    std::vector<Vertex> _vertices;
+    std::vector<unsigned int> _all_indices;
+    std::vector<unsigned int> _indices;
+
+    std::shared_ptr<ES2Geometry> _geometry;
+    std::shared_ptr<Mesh> _mesh;
+};
+
+// Occlusion culling on the CPU. Selected occluders are rasterized every
+// frame into a small depth buffer (four pixels per SSE instruction) that is
+// reduced into a pyramid keeping the farthest depth of every 2x2 block. An
+// object is occluded when the nearest point of its bounding box is behind
+// the farthest occluder depth over the screen rectangle it covers, which is
+// read from the pyramid level where that rectangle spans a few texels.
+// Occluder triangles crossing the near plane are skipped, and objects that
+// cross it are never occluded, so mistakes only ever cost a draw.
+class OcclusionCuller {
+public:
+    struct Statistics {
+        unsigned int occluder_triangles{ 0 };
+        unsigned int rasterized_triangles{ 0 };
+        unsigned int tested_objects{ 0 };
+        unsigned int occluded_objects{ 0 };
+    };
+
+    OcclusionCuller()
+    {
+        static_assert(OCCLUSION_BUFFER_WIDTH % 4U == 0U, "rows are rasterized four pixels at a time");
+
+        unsigned int width{ OCCLUSION_BUFFER_WIDTH }, height{ OCCLUSION_BUFFER_HEIGHT };
+        for (;;) {
+            _levels.push_back(DepthLevel{ width, height, std::vector<float>(static_cast<size_t>(width) * height, 1.0f) });
+            if (width == 1U && height == 1U) {
+                break;
+            }
+            width = std::max(width / 2U, 1U);
+            height = std::max(height / 2U, 1U);
+        }
+    }
+
+    void add_occluder_box(const glm::vec3& min, const glm::vec3& max)
+    {
+        std::array<glm::vec3, 8> corners{
+            glm::vec3{ min.x, min.y, min.z }, glm::vec3{ max.x, min.y, min.z },
+            glm::vec3{ min.x, max.y, min.z }, glm::vec3{ max.x, max.y, min.z },
+            glm::vec3{ min.x, min.y, max.z }, glm::vec3{ max.x, min.y, max.z },
+            glm::vec3{ min.x, max.y, max.z }, glm::vec3{ max.x, max.y, max.z }
+        };
+        static const unsigned int BOX_INDICES[36]{
+            0, 1, 3, 0, 3, 2,  4, 6, 7, 4, 7, 5,
+            0, 2, 6, 0, 6, 4,  1, 5, 7, 1, 7, 3,
+            0, 4, 5, 0, 5, 1,  2, 3, 7, 2, 7, 6
+        };
+        for (auto index : BOX_INDICES) {
+            _occluder_vertices.push_back(corners[index]);
+        }
+    }
+
+    // Clears the depth buffer, draws all occluders and builds the pyramid.
+    void rasterize(const glm::mat4& view_projection_matrix)
+    {
+        _view_projection_matrix = view_projection_matrix;
+        _statistics = Statistics{};
+        _statistics.occluder_triangles = static_cast<unsigned int>(_occluder_vertices.size() / 3);
+
+        auto& depth = _levels[0].depth;
+        std::fill(depth.begin(), depth.end(), 1.0f);
+
+        for (size_t i = 0; i + 2 < _occluder_vertices.size(); i += 3) {
+            std::array<glm::vec4, 3> clip{
+                view_projection_matrix * glm::vec4(_occluder_vertices[i], 1.0f),
+                view_projection_matrix * glm::vec4(_occluder_vertices[i + 1], 1.0f),
+                view_projection_matrix * glm::vec4(_occluder_vertices[i + 2], 1.0f)
+            };
+            if (clip[0].w < OCCLUSION_NEAR_W || clip[1].w < OCCLUSION_NEAR_W || clip[2].w < OCCLUSION_NEAR_W) {
+                continue;
+            }
+            _rasterize_triangle(_to_screen(clip[0]), _to_screen(clip[1]), _to_screen(clip[2]));
+        }
+
+        _build_pyramid();
+    }
+
+    // Uses the matrix of the last rasterize() call.
+    [[nodiscard]] bool is_occluded(const glm::vec3& min, const glm::vec3& max)
+    {
+        ++_statistics.tested_objects;
+
+        float min_x{ std::numeric_limits<float>::max() }, min_y{ std::numeric_limits<float>::max() };
+        float max_x{ std::numeric_limits<float>::lowest() }, max_y{ std::numeric_limits<float>::lowest() };
+        float nearest_depth{ 1.0f };
+        for (auto corner = 0U; corner < 8U; ++corner) {
+            glm::vec4 position{
+                (corner & 1U) != 0U ? max.x : min.x,
+                (corner & 2U) != 0U ? max.y : min.y,
+                (corner & 4U) != 0U ? max.z : min.z,
+                1.0f
+            };
+            glm::vec4 clip = _view_projection_matrix * position;
+            if (clip.w < OCCLUSION_NEAR_W) {
+                return false;
+            }
+            glm::vec3 screen = _to_screen(clip);
+            min_x = std::min(min_x, screen.x);
+            min_y = std::min(min_y, screen.y);
+            max_x = std::max(max_x, screen.x);
+            max_y = std::max(max_y, screen.y);
+            nearest_depth = std::min(nearest_depth, screen.z);
+        }
+
+        auto width = static_cast<float>(OCCLUSION_BUFFER_WIDTH), height = static_cast<float>(OCCLUSION_BUFFER_HEIGHT);
+        if (max_x < 0.0f || max_y < 0.0f || min_x >= width || min_y >= height) {
+            return false;
+        }
+        auto x0 = static_cast<unsigned int>(std::max(min_x, 0.0f));
+        auto y0 = static_cast<unsigned int>(std::max(min_y, 0.0f));
+        auto x1 = static_cast<unsigned int>(std::min(max_x, width - 1.0f));
+        auto y1 = static_cast<unsigned int>(std::min(max_y, height - 1.0f));
+
+        unsigned int level{ 0 };
+        while (level + 1 < _levels.size() && std::max(x1 - x0, y1 - y0) > 1U) {
+            ++level;
+            x0 >>= 1U; y0 >>= 1U; x1 >>= 1U; y1 >>= 1U;
+        }
+
+        const auto& depth_level = _levels[level];
+        for (auto y = y0; y <= y1; ++y) {
+            for (auto x = x0; x <= x1; ++x) {
+                if (nearest_depth <= depth_level.depth[static_cast<size_t>(y) * depth_level.width + x]) {
+                    return false;
+                }
+            }
+        }
+
+        ++_statistics.occluded_objects;
+        return true;
+    }
+
+    [[nodiscard]] const Statistics& get_statistics() const
+    {
+        return _statistics;
+    }
+
+private:
+    struct DepthLevel {
+        unsigned int width, height;
+        std::vector<float> depth;
     };
 
-    Enemy(const glm::vec3& position, float size, float speed, const enemy_sprite_data_type& enemy_sprite_data)
-        : _position{ position }, _speed(speed)
+    std::vector<glm::vec3> _occluder_vertices;
+    std::vector<DepthLevel> _levels;
+    glm::mat4 _view_projection_matrix{ 1.0f };
+    Statistics _statistics;
+
+    // Pixel coordinates with y going down and the depth mapped to [0, 1].
+    [[nodiscard]] static glm::vec3 _to_screen(const glm::vec4& clip)
+    {
+        glm::vec3 ndc = glm::vec3(clip) / clip.w;
+        return glm::vec3{
+            (ndc.x * 0.5f + 0.5f) * static_cast<float>(OCCLUSION_BUFFER_WIDTH),
+            (0.5f - ndc.y * 0.5f) * static_cast<float>(OCCLUSION_BUFFER_HEIGHT),
+            ndc.z * 0.5f + 0.5f
+        };
+    }
+
+    void _rasterize_triangle(glm::vec3 v0, glm::vec3 v1, glm::vec3 v2)
+    {
+        float area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+        if (area == 0.0f) {
+            return;
+        }
+        if (area < 0.0f) {
+            std::swap(v1, v2);
+            area = -area;
+        }
+
+        float min_x = std::max(std::min({ v0.x, v1.x, v2.x }), 0.0f);
+        float min_y = std::max(std::min({ v0.y, v1.y, v2.y }), 0.0f);
+        float max_x = std::min(std::max({ v0.x, v1.x, v2.x }), static_cast<float>(OCCLUSION_BUFFER_WIDTH) - 1.0f);
+        float max_y = std::min(std::max({ v0.y, v1.y, v2.y }), static_cast<float>(OCCLUSION_BUFFER_HEIGHT) - 1.0f);
+        if (min_x > max_x || min_y > max_y) {
+            return;
+        }
+        ++_statistics.rasterized_triangles;
+
+        // Edge function of the edge a -> b at p: (b.x - a.x) * (p.y - a.y) - (b.y - a.y) * (p.x - a.x),
+        // written as row + step * p.x. It is not negative inside the triangle.
+        std::array<glm::vec2, 3> edge_starts{ glm::vec2(v1), glm::vec2(v2), glm::vec2(v0) };
+        std::array<glm::vec2, 3> edge_ends{ glm::vec2(v2), glm::vec2(v0), glm::vec2(v1) };
+        std::array<float, 3> steps{};
+        for (auto i = 0U; i < 3U; ++i) {
+            steps[i] = edge_starts[i].y - edge_ends[i].y;
+        }
+        float inverse_area = 1.0f / area;
+        std::array<float, 3> depths{ v0.z * inverse_area, v1.z * inverse_area, v2.z * inverse_area };
+
+        auto& buffer = _levels[0].depth;
+        auto x_begin = static_cast<unsigned int>(min_x) & ~3U;
+        auto x_end = static_cast<unsigned int>(max_x);
+        for (auto y = static_cast<unsigned int>(min_y); y <= static_cast<unsigned int>(max_y); ++y) {
+            float pixel_y = static_cast<float>(y) + 0.5f;
+            std::array<float, 3> rows{};
+            for (auto i = 0U; i < 3U; ++i) {
+                rows[i] = (edge_ends[i].x - edge_starts[i].x) * (pixel_y - edge_starts[i].y) - steps[i] * edge_starts[i].x;
+            }
+            float* row = &buffer[static_cast<size_t>(y) * OCCLUSION_BUFFER_WIDTH];
+
+#if GAME_TEST_SSE
+            __m128 offsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+            __m128 zero = _mm_setzero_ps();
+            for (auto x = x_begin; x <= x_end; x += 4U) {
+                __m128 pixel_x = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), offsets);
+                __m128 w0 = _mm_add_ps(_mm_set1_ps(rows[0]), _mm_mul_ps(_mm_set1_ps(steps[0]), pixel_x));
+                __m128 w1 = _mm_add_ps(_mm_set1_ps(rows[1]), _mm_mul_ps(_mm_set1_ps(steps[1]), pixel_x));
+                __m128 w2 = _mm_add_ps(_mm_set1_ps(rows[2]), _mm_mul_ps(_mm_set1_ps(steps[2]), pixel_x));
+                __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(w0, zero), _mm_cmpge_ps(w1, zero)), _mm_cmpge_ps(w2, zero));
+
+                __m128 depth = _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(w0, _mm_set1_ps(depths[0])), _mm_mul_ps(w1, _mm_set1_ps(depths[1]))),
+                    _mm_mul_ps(w2, _mm_set1_ps(depths[2]))
+                );
+                __m128 stored = _mm_loadu_ps(row + x);
+                __m128 write = _mm_and_ps(inside, _mm_cmplt_ps(depth, stored));
+                _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(write, depth), _mm_andnot_ps(write, stored)));
+            }
+#else
+            for (auto x = x_begin; x <= x_end; ++x) {
+                float pixel_x = static_cast<float>(x) + 0.5f;
+                float w0 = rows[0] + steps[0] * pixel_x;
+                float w1 = rows[1] + steps[1] * pixel_x;
+                float w2 = rows[2] + steps[2] * pixel_x;
+                if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f) {
+                    continue;
+                }
+                float depth = w0 * depths[0] + w1 * depths[1] + w2 * depths[2];
+                row[x] = std::min(row[x], depth);
+            }
+#endif
+        }
+    }
+
+    void _build_pyramid()
+    {
+        for (size_t level = 1; level < _levels.size(); ++level) {
+            const auto& source = _levels[level - 1];
+            auto& target = _levels[level];
+            for (auto y = 0U; y < target.height; ++y) {
+                unsigned int y0 = std::min(y * 2U, source.height - 1U), y1 = std::min(y * 2U + 1U, source.height - 1U);
+                for (auto x = 0U; x < target.width; ++x) {
+                    unsigned int x0 = std::min(x * 2U, source.width - 1U), x1 = std::min(x * 2U + 1U, source.width - 1U);
+                    target.depth[static_cast<size_t>(y) * target.width + x] = std::max({
+                        source.depth[static_cast<size_t>(y0) * source.width + x0],
+                        source.depth[static_cast<size_t>(y0) * source.width + x1],
+                        source.depth[static_cast<size_t>(y1) * source.width + x0],
+                        source.depth[static_cast<size_t>(y1) * source.width + x1]
+                    });
+                }
+            }
+        }
+    }
+};
+
+class BillboardBatch {
+public:
+    typedef std::tuple<const std::string, unsigned int> billboard_sprite_data_type;
+
+    BillboardBatch(size_t capacity, const billboard_sprite_data_type& sprite_data) : _capacity{ capacity }
     {
-        const auto& [sprite_file, sprite_frame_count, first_dying_state_sprite_frame] = enemy_sprite_data;
+        const auto& [sprite_file, sprite_frame_count] = sprite_data;
+        _frame_count = sprite_frame_count;
 
         auto [image_data, image_width, image_height, image_channels] = file_utilities::read_image_file(sprite_file);
-        _texture = std::make_shared<ES2Texture>(image_data, image_width, image_height, image_channels);
-        _texture->set_minification_filter(Texture::FilterType::Nearest);
-        _texture->set_magnification_filter(Texture::FilterType::Nearest);
-        _texture->set_mode(Texture::Mode::Modulation);
-        _texture->set_transformation_enabled(true);
-        _set_texture_frames(sprite_frame_count);
-        _set_first_dying_texture_frame(first_dying_state_sprite_frame);
+        auto texture = std::make_shared<ES2Texture>(image_data, image_width, image_height, image_channels);
+        texture->set_minification_filter(Texture::FilterType::Nearest);
+        texture->set_magnification_filter(Texture::FilterType::Nearest);
+        texture->set_mode(Texture::Mode::Modulation);
+
+        auto [quad_indices, quad_vertices] = copy_fixed_mesh(SPRITE_QUAD_MESH);
+        _quad_vertices = quad_vertices;
+        _quad_indices = quad_indices;
+
+        _positions.reserve(capacity);
+        _sizes.reserve(capacity);
+        _frames.reserve(capacity);
+        _visible.reserve(capacity);
+        _occluded.reserve(capacity);
+        _order.reserve(capacity);
+        _distances.reserve(capacity);
+
+        _vertices.reserve(capacity * _quad_vertices.size());
+        _indices.reserve(capacity * _quad_indices.size());
+
+        _geometry = std::make_shared<ES2Geometry>(_indices, _vertices);
+        auto material = std::make_shared<ES2ConstantMaterial>();
+        material->set_texture_1(texture);
+        material->set_blending_enabled(true);
+        material->set_face_culling_enabled(false);
+        material->set_transparent(true);
+
+        _mesh = std::make_shared<Mesh>(_geometry, material);
+    }
+
+    [[nodiscard]] const std::shared_ptr<Mesh>& get_mesh() const
+    {
+        return _mesh;
+    }
+
+    [[nodiscard]] unsigned int get_frame_count() const
+    {
+        return _frame_count;
+    }
+
+    unsigned int add_sprite(const glm::vec3& position, float size)
+    {
+        assert(_positions.size() < _capacity);
+
+        _positions.push_back(position);
+        _sizes.push_back(size);
+        _frames.push_back(0);
+        _visible.push_back(1);
+        _occluded.push_back(0);
+
+        return static_cast<unsigned int>(_positions.size() - 1);
+    }
+
+    void set_sprite_position(unsigned int sprite, const glm::vec3& position)
+    {
+        _positions[sprite] = position;
+    }
+
+    void set_sprite_frame(unsigned int sprite, unsigned int frame)
+    {
+        _frames[sprite] = frame;
+    }
+
+    void set_sprite_visible(unsigned int sprite, bool visible)
+    {
+        _visible[sprite] = visible ? 1 : 0;
+    }
+
+    // Set by occlusion culling every frame, independently of the visibility
+    // the game logic controls.
+    void set_sprite_occluded(unsigned int sprite, bool occluded)
+    {
+        _occluded[sprite] = occluded ? 1 : 0;
+    }
+
+    [[nodiscard]] unsigned int get_sprite_count() const
+    {
+        return static_cast<unsigned int>(_positions.size());
+    }
+
+    [[nodiscard]] bool is_sprite_visible(unsigned int sprite) const
+    {
+        return _visible[sprite] != 0;
+    }
+
+    [[nodiscard]] const glm::vec3& get_sprite_position(unsigned int sprite) const
+    {
+        return _positions[sprite];
+    }
+
+    [[nodiscard]] float get_sprite_size(unsigned int sprite) const
+    {
+        return _sizes[sprite];
+    }
+
+    // Rebuilds the whole vertex stream in one pass: every visible sprite is
+    // turned toward the camera around the world up axis and sorted back to
+    // front, so the batch blends correctly with a single draw call. Only CPU
+    // data is touched here, upload() hands it to the geometry afterwards.
+    void build(const glm::vec3& camera_position, const glm::vec3& camera_right)
+    {
+        glm::vec3 right = camera_right;
+        right.y = 0.0f;
+        right = glm::length(right) > 0.0f ? glm::normalize(right) : glm::vec3{ 1.0f, 0.0f, 0.0f };
+        glm::vec3 up{ 0.0f, 1.0f, 0.0f };
+        glm::vec3 normal = glm::cross(right, up);
+
+        _order.clear();
+        _distances.resize(_positions.size());
+        for (auto sprite = 0U; sprite < _positions.size(); ++sprite) {
+            glm::vec3 offset = _positions[sprite] - camera_position;
+            _distances[sprite] = glm::dot(offset, offset);
+            if (_visible[sprite] && !_occluded[sprite]) {
+                _order.push_back(sprite);
+            }
+        }
+        std::sort(_order.begin(), _order.end(), [this](unsigned int a, unsigned int b) {
+            return _distances[a] > _distances[b];
+        });
+
+        size_t quad_vertex_count = _quad_vertices.size();
+        float frame_width = 1.0f / static_cast<float>(_frame_count);
+
+        _vertices.resize(_order.size() * quad_vertex_count);
+        for (auto i = 0U; i < _order.size(); ++i) {
+            unsigned int sprite = _order[i];
+            glm::vec3 position = _positions[sprite];
+            float size = _sizes[sprite];
+            float frame_offset = static_cast<float>(_frames[sprite]) * frame_width;
+
+            for (auto j = 0U; j < quad_vertex_count; ++j) {
+                const auto& quad_vertex = _quad_vertices[j];
+                auto& vertex = _vertices[i * quad_vertex_count + j];
+
+                vertex = quad_vertex;
+                vertex.position = position + (right * quad_vertex.position.x + up * quad_vertex.position.y) * size;
+                vertex.normal = normal;
+                vertex.texture_coordinates.x = frame_offset + quad_vertex.texture_coordinates.x * frame_width;
+            }
+        }
+
+        if (_order.size() != _indexed_sprite_count) {
+            _indices.clear();
+            for (auto i = 0U; i < _order.size(); ++i) {
+                for (auto index : _quad_indices) {
+                    _indices.push_back(static_cast<unsigned int>(i * quad_vertex_count + index));
+                }
+            }
+            _indexed_sprite_count = _order.size();
+            _indices_changed = true;
+        }
+    }
+
+    void upload()
+    {
+        if (_indices_changed) {
+            _geometry->set_indices(_indices);
+            _indices_changed = false;
+        }
+        _geometry->set_vertices(_vertices);
+    }
+
+private:
+    size_t _capacity;
+    unsigned int _frame_count{ 1 };
+
+    std::vector<glm::vec3> _positions;
+    std::vector<float> _sizes;
+    std::vector<unsigned int> _frames;
+    std::vector<uint8_t> _visible;
+    std::vector<uint8_t> _occluded;
+
+    std::vector<unsigned int> _order;
+    std::vector<float> _distances;
+
+    std::vector<Vertex> _quad_vertices;
+    std::vector<unsigned int> _quad_indices;
+    std::vector<Vertex> _vertices;
+    std::vector<unsigned int> _indices;
+    size_t _indexed_sprite_count{ 0 };
+    bool _indices_changed{ false };
+
+    std::shared_ptr<ES2Geometry> _geometry;
+    std::shared_ptr<Mesh> _mesh;
+};
+
+// Runs the simulation in constant steps no matter how fast frames are
+// rendered. Real frame time is accumulated and consumed one step at a time;
+// what is left over is returned as the blend factor between the last two
+// simulated states. Long stalls are capped so the simulation never tries to
+// catch up with more than a few steps in one frame.
+class FixedTimestep {
+public:
+    FixedTimestep(float step, unsigned int max_steps_per_frame)
+        : _step{ step }, _max_steps_per_frame{ max_steps_per_frame }
+    {
+    }
+
+    [[nodiscard]] float get_step() const
+    {
+        return _step;
+    }
+
+    [[nodiscard]] double get_time() const
+    {
+        return _time;
+    }
+
+    [[nodiscard]] unsigned long long get_step_count() const
+    {
+        return _step_count;
+    }
+
+    template<typename Simulate>
+    float advance(float frame_time, Simulate&& simulate)
+    {
+        _accumulator += std::min(frame_time, _step * static_cast<float>(_max_steps_per_frame));
+        while (_accumulator >= _step) {
+            simulate(_step);
+            _accumulator -= _step;
+            _time += _step;
+            ++_step_count;
+        }
+
+        return _accumulator / _step;
+    }
+
+private:
+    float _step;
+    unsigned int _max_steps_per_frame;
+    float _accumulator{ 0.0f };
+    double _time{ 0.0 };
+    unsigned long long _step_count{ 0 };
+};
+
+// All enemies of the level stored as parallel arrays. One update walks the
+// arrays front to back in two branch-free passes: the animation, and the
+// movement with the "reached the player" test on squared distances, four
+// enemies at a time. The states only change the data the passes read (a
+// dying enemy has no speed and no reach), so the few enemies that are dying
+// are finished in a separate pass. The passes are split into independent
+// ranges that run as jobs once the horde is large enough to pay for them.
+// Sprites and the broadphase are synchronized in separate passes because
+// neither of them is thread-safe.
+class EnemySystem {
+public:
+    enum State : uint8_t {
+        Alive,
+        Dying,
+        Dead
+    };
 
-        auto [billboard_indices, billboard_vertices] = geometry_generators::generate_plane_geometry_data(size, size, 1, 1);
-        auto billboard_geometry = std::make_shared<ES2Geometry>(billboard_indices, billboard_vertices);
-        auto billboard_material = std::make_shared<ES2ConstantMaterial>();
-        billboard_material->set_texture_1(_texture);
-        billboard_material->set_blending_enabled(true);
-        billboard_material->set_face_culling_enabled(false);
-        billboard_material->set_transparent(true);
+    EnemySystem(
+        JobSystem& jobs, const std::shared_ptr<BillboardBatch>& sprites, const std::shared_ptr<EnemyGrid>& broadphase,
+        unsigned int first_dying_sprite_frame
+    ) : _jobs{ jobs }, _sprites{ sprites }, _broadphase{ broadphase },
+        _frame_count{ sprites->get_frame_count() }, _first_dying_frame{ first_dying_sprite_frame }
+    {
+    }
 
-        _mesh = std::make_shared<Mesh>(billboard_geometry, billboard_material);
-        _mesh->set_position(position);
-        _bounding_volume = Sphere{ _mesh->get_position(), size / 2 };
+    unsigned int spawn(const glm::vec3& position, float size, float speed)
+    {
+        unsigned int enemy = static_cast<unsigned int>(_states.size());
+
+        _positions_x.push_back(position.x);
+        _positions_y.push_back(position.y);
+        _positions_z.push_back(position.z);
+        _previous_positions_x.push_back(position.x);
+        _previous_positions_z.push_back(position.z);
+        _speeds.push_back(speed);
+        _radii.push_back(size / 2.0f);
+        _reaches_squared.push_back(size * size / 16.0f);
+        _states.push_back(Alive);
+        _frames.push_back(0);
+        _animation_times.push_back(0.0f);
+        _animation_first_frames.push_back(0);
+        _animation_frame_counts.push_back(0);
+        _animation_cycles.push_back(0.0f);
+        _set_animation(enemy, 0, _first_dying_frame, static_cast<float>(_first_dying_frame));
+
+        _sprites->add_sprite(position, size);
+        _broadphase->insert(enemy, Sphere{ position, size / 2.0f });
+
+        return enemy;
     }
 
-    [[nodiscard]] const std::shared_ptr<Mesh>& get_mesh() const
+    void set_animation_frame_time(float animation_frame_time)
     {
-        return _mesh;
+        _animation_frame_time = animation_frame_time;
     }
 
-    void set_target(const std::shared_ptr<Camera>& target)
+    [[nodiscard]] size_t get_count() const
     {
-        _target = target;
+        return _states.size();
     }
 
-    void set_update_rate(int update_rate)
+    [[nodiscard]] size_t get_dead_count() const
     {
-        _update_rate = update_rate;
+        return static_cast<size_t>(std::count(_states.begin(), _states.end(), Dead));
     }
 
-    [[nodiscard]] const State get_state() const
+    [[nodiscard]] State get_state(unsigned int enemy) const
     {
-        return _state;
+        return static_cast<State>(_states[enemy]);
     }
 
-    void update(float delta_time)
+    [[nodiscard]] const EnemyGrid& get_broadphase() const
     {
-        if (_state == Dying) {
-            if (_update_request++ % _update_rate != 0) {
-                return;
-            }
+        return *_broadphase;
+    }
 
-            unsigned int frame = _texture_frame + 1;
-            if (frame >= _texture_frames) {
-                _state = Dead;
-            }
-            else {
-                _set_texture_frame(frame);
-            }
+    void kill(unsigned int enemy)
+    {
+        if (_states[enemy] == Alive) {
+            _states[enemy] = Dying;
+            _speeds[enemy] = 0.0f;
+            _reaches_squared[enemy] = 0.0f;
+            // The dying frames play once, the cycle never wraps.
+            _set_animation(enemy, _first_dying_frame, _frame_count - _first_dying_frame, std::numeric_limits<float>::max());
+            _frames[enemy] = _first_dying_frame;
+            _dying.push_back(enemy);
+            _broadphase->remove(enemy);
         }
-        else if (_state == Alive) {
-            if (_update_request++ % _update_rate != 0 || _target == nullptr) {
-                return;
-            }
-
-            _set_texture_frame((_texture_frame + 1) % _first_dying_texture_frame);
-
-            glm::vec3 target = _target->get_world_position();
-            glm::vec3 position = _position;
-            target.y = position.y;
-
-            _velocity = glm::normalize(target - position) * _speed * delta_time;
-            _position += _velocity;
-            _mesh->set_position(_position);
-            _bounding_volume.set_center(_position);
-
-            float enemy_x{ _position.x };
-            float enemy_z{ _position.z };
-            float player_x{ target.x };
-            float player_z{ target.z };
+    }
 
-            if (sqrt((enemy_x - player_x) * (enemy_x - player_x) + (enemy_z - player_z) * (enemy_z - player_z)) 
-                < _bounding_volume.get_radius()/2.0f)
-            {
-                GAME_IS_LOST = true;
-                return;
+    // Advances the simulation by one step. Returns true when any enemy reached the target.
+    bool update(float delta_time, const glm::vec3& target)
+    {
+        std::atomic<bool> target_reached{ false };
+        _jobs.parallel_for(_states.size(), ENEMY_SYSTEM_PARALLEL_BATCH_SIZE, [&](size_t begin, size_t end) {
+            _animate_range(begin, end, delta_time);
+            if (_move_range(begin, end, delta_time, target)) {
+                target_reached = true;
             }
-            
-        }
+        });
+        _finish_dying();
 
-        _mesh->billboard_toward_camera(_target);
+        return target_reached;
     }
 
-    [[nodiscard]] bool intersects_with_ray(const Ray& ray) const
+    void update_broadphase()
     {
-        return ray.intersects_with_sphere(_bounding_volume).first;
+        for (auto enemy = 0U; enemy < _states.size(); ++enemy) {
+            if (_states[enemy] == Alive) {
+                glm::vec3 position{ _positions_x[enemy], _positions_y[enemy], _positions_z[enemy] };
+                _broadphase->move(enemy, Sphere{ position, _radii[enemy] });
+            }
+        }
     }
 
-    void kill()
+    // Hands the state to the sprites, blended between the last two steps.
+    void publish(float alpha)
     {
-        if (_state == Alive) {
-            _state = Dying;
-            _set_texture_frame(_first_dying_texture_frame);
+        for (auto enemy = 0U; enemy < _states.size(); ++enemy) {
+            glm::vec3 position{
+                _previous_positions_x[enemy] + (_positions_x[enemy] - _previous_positions_x[enemy]) * alpha,
+                _positions_y[enemy],
+                _previous_positions_z[enemy] + (_positions_z[enemy] - _previous_positions_z[enemy]) * alpha
+            };
+            _sprites->set_sprite_position(enemy, position);
+            _sprites->set_sprite_frame(enemy, _frames[enemy]);
+            _sprites->set_sprite_visible(enemy, _states[enemy] != Dead);
         }
     }
 
 private:
-    State _state{ Alive };
-
-    glm::vec3 _position;
-    float _speed{ 1.0f };
-    glm::vec3 _velocity{ 0.0f };
-
-    std::shared_ptr<Mesh> _mesh;
-    Sphere _bounding_volume{ glm::vec3{0.0f}, 1.0f };
-
-    std::shared_ptr<Camera> _target{ nullptr };
-
-    int _update_request{ 0 };
-    int _update_rate{ 10 };
-
-    std::shared_ptr<ES2Texture> _texture;
-    unsigned int _texture_frame{ 0 };
-    unsigned int _texture_frames{ 1 };
-    unsigned int _first_dying_texture_frame{ 0 };
+    JobSystem& _jobs;
+    std::shared_ptr<BillboardBatch> _sprites;
+    std::shared_ptr<EnemyGrid> _broadphase;
+
+    unsigned int _frame_count;
+    unsigned int _first_dying_frame;
+    float _animation_frame_time{ 1.0f / 6.0f };
+
+    std::vector<float> _positions_x, _positions_y, _positions_z;
+    std::vector<float> _previous_positions_x, _previous_positions_z;
+    // Zero for the enemies that are not alive, they neither move nor reach.
+    std::vector<float> _speeds;
+    std::vector<float> _reaches_squared;
+    std::vector<float> _radii;
+    std::vector<uint8_t> _states;
+    std::vector<unsigned int> _frames;
+    // The animation time is in frames and wraps after the cycle. The frame
+    // shown is the first frame plus the whole frames, clamped to the count.
+    std::vector<float> _animation_times;
+    std::vector<unsigned int> _animation_first_frames;
+    std::vector<unsigned int> _animation_frame_counts;
+    std::vector<float> _animation_cycles;
+    std::vector<unsigned int> _dying;
+
+    void _set_animation(unsigned int enemy, unsigned int first_frame, unsigned int frame_count, float cycle)
+    {
+        _animation_times[enemy] = 0.0f;
+        _animation_first_frames[enemy] = first_frame;
+        _animation_frame_counts[enemy] = frame_count;
+        _animation_cycles[enemy] = cycle;
+    }
 
-    void _set_texture_frame(unsigned int texture_frame)
+    void _animate_range(size_t begin, size_t end, float delta_time)
     {
-        _texture_frame = texture_frame;
-        glm::mat4 matrix = _texture->get_transformation_matrix();
-        matrix[3][0] = static_cast<float>(_texture_frame) / static_cast<float>(_texture_frames);
-        _texture->set_transformation_matrix(matrix);
+        float frame_steps = delta_time / _animation_frame_time;
+        for (size_t enemy = begin; enemy < end; ++enemy) {
+            float time = _animation_times[enemy] + frame_steps;
+            float cycle = _animation_cycles[enemy];
+            time -= cycle * static_cast<float>(static_cast<int>(time / cycle));
+            _animation_times[enemy] = time;
+
+            unsigned int frame = std::min(static_cast<unsigned int>(time), _animation_frame_counts[enemy] - 1);
+            _frames[enemy] = _animation_first_frames[enemy] + frame;
+        }
     }
 
-    void _set_texture_frames(unsigned int texture_frames)
+    bool _move_range(size_t begin, size_t end, float delta_time, const glm::vec3& target)
     {
-        _texture_frames = texture_frames;
-        glm::mat4 matrix = _texture->get_transformation_matrix();
-        matrix[0][0] = 1.0f / static_cast<float>(_texture_frames);
-        matrix[3][0] = static_cast<float>(_texture_frame) / static_cast<float>(_texture_frames);
-        _texture->set_transformation_matrix(matrix);
+        std::copy(_positions_x.begin() + begin, _positions_x.begin() + end, _previous_positions_x.begin() + begin);
+        std::copy(_positions_z.begin() + begin, _positions_z.begin() + end, _previous_positions_z.begin() + begin);
+
+        bool target_reached{ false };
+        size_t enemy{ begin };
+        // The distance is kept above zero so that an enemy on the target
+        // steps by a zero offset instead of dividing by zero.
+        const float smallest_distance_squared{ std::numeric_limits<float>::min() };
+#if GAME_TEST_SSE
+        __m128 target_x = _mm_set1_ps(target.x), target_z = _mm_set1_ps(target.z);
+        __m128 step_time = _mm_set1_ps(delta_time);
+        __m128 smallest = _mm_set1_ps(smallest_distance_squared);
+        __m128 reached = _mm_setzero_ps();
+        for (; enemy + 4 <= end; enemy += 4) {
+            __m128 position_x = _mm_loadu_ps(&_positions_x[enemy]);
+            __m128 position_z = _mm_loadu_ps(&_positions_z[enemy]);
+
+            __m128 offset_x = _mm_sub_ps(target_x, position_x);
+            __m128 offset_z = _mm_sub_ps(target_z, position_z);
+            __m128 distance_squared = _mm_add_ps(_mm_mul_ps(offset_x, offset_x), _mm_mul_ps(offset_z, offset_z));
+            __m128 step = _mm_div_ps(
+                _mm_mul_ps(_mm_loadu_ps(&_speeds[enemy]), step_time),
+                _mm_sqrt_ps(_mm_max_ps(distance_squared, smallest))
+            );
+            position_x = _mm_add_ps(position_x, _mm_mul_ps(offset_x, step));
+            position_z = _mm_add_ps(position_z, _mm_mul_ps(offset_z, step));
+            _mm_storeu_ps(&_positions_x[enemy], position_x);
+            _mm_storeu_ps(&_positions_z[enemy], position_z);
+
+            offset_x = _mm_sub_ps(position_x, target_x);
+            offset_z = _mm_sub_ps(position_z, target_z);
+            distance_squared = _mm_add_ps(_mm_mul_ps(offset_x, offset_x), _mm_mul_ps(offset_z, offset_z));
+            reached = _mm_or_ps(reached, _mm_cmplt_ps(distance_squared, _mm_loadu_ps(&_reaches_squared[enemy])));
+        }
+        target_reached = _mm_movemask_ps(reached) != 0;
+#endif
+        for (; enemy < end; ++enemy) {
+            float offset_x = target.x - _positions_x[enemy];
+            float offset_z = target.z - _positions_z[enemy];
+            float distance_squared = offset_x * offset_x + offset_z * offset_z;
+            float step = _speeds[enemy] * delta_time / std::sqrt(std::max(distance_squared, smallest_distance_squared));
+            _positions_x[enemy] += offset_x * step;
+            _positions_z[enemy] += offset_z * step;
+
+            offset_x = _positions_x[enemy] - target.x;
+            offset_z = _positions_z[enemy] - target.z;
+            target_reached |= offset_x * offset_x + offset_z * offset_z < _reaches_squared[enemy];
+        }
+
+        return target_reached;
     }
 
-    void _set_first_dying_texture_frame(unsigned int first_dying_texture_frame)
+    // Marks the enemies that played all of their dying frames as dead.
+    void _finish_dying()
     {
-        _first_dying_texture_frame = first_dying_texture_frame;
+        for (size_t i = 0; i < _dying.size();) {
+            unsigned int enemy = _dying[i];
+            if (_animation_times[enemy] < static_cast<float>(_animation_frame_counts[enemy])) {
+                ++i;
+                continue;
+            }
+
+            _states[enemy] = Dead;
+            _set_animation(enemy, _frame_count - 1, 1, 1.0f);
+            _frames[enemy] = _frame_count - 1;
+            _dying[i] = _dying.back();
+            _dying.pop_back();
+        }
     }
 };
 
@@ -203,7 +1497,7 @@ public:
         _texture->set_transformation_enabled(true);
         _set_texture_frames(sprite_frame_count);
 
-        auto [overlay_indices, overlay_vertices] = geometry_generators::generate_plane_geometry_data(2, 2, 1, 1);
+        auto [overlay_indices, overlay_vertices] = copy_fixed_mesh(OVERLAY_QUAD_MESH);
         auto overlay_geometry = std::make_shared<ES2Geometry>(overlay_indices, overlay_vertices);
         auto overlay_material = std::make_shared<ES2ConstantMaterial>();
         overlay_material->set_texture_1(_texture);
@@ -221,48 +1515,57 @@ public:
         return _mesh;
     }
 
-    void set_point_of_view(const std::shared_ptr<Camera>& point_of_view)
+    void set_point_of_view(const std::shared_ptr<CameraMatrices>& point_of_view)
     {
         _point_of_view = point_of_view;
     }
 
-    void set_update_rate(int update_rate)
+    void set_animation_frame_time(float animation_frame_time)
     {
-        _update_rate = update_rate;
+        _animation_frame_time = animation_frame_time;
     }
 
-    void update()
+    void update(float delta_time)
     {
         if (_state == Shooting) {
-            if (_update_request++ % _update_rate != 0) {
+            _frame_time += delta_time;
+            if (_frame_time < _animation_frame_time) {
                 return;
             }
+            _frame_time -= _animation_frame_time;
 
             unsigned int frame = _texture_frame + 1;
             if (frame >= _texture_frames) {
                 _state = Idling;
-                _set_texture_frame(0);
+                _texture_frame = 0;
             }
             else {
-                _set_texture_frame(frame);
+                _texture_frame = frame;
             }
         }
     }
 
-    void shoot(const std::vector<std::shared_ptr<Enemy>>& enemies)
+    // Applies the animation frame picked by update() to the texture.
+    void publish()
+    {
+        _set_texture_frame(_texture_frame);
+    }
+
+    void shoot(EnemySystem& enemies)
     {
         if (_state == Idling) {
             _state = Shooting;
+            _frame_time = 0.0f;
 
             if (_point_of_view == nullptr) {
                 return;
             }
 
-            for (auto& enemy : enemies) {
-                if (enemy->intersects_with_ray(_point_of_view->world_ray_from_screen_point(_target.x, _target.y))) {
-                    enemy->kill();
-                    return;
-                }
+            glm::vec3 origin, direction;
+            _point_of_view->world_ray_from_screen_point(_target, origin, direction);
+            int enemy = enemies.get_broadphase().closest_hit(origin, direction);
+            if (enemy >= 0) {
+                enemies.kill(static_cast<unsigned int>(enemy));
             }
         }
     }
@@ -271,11 +1574,11 @@ private:
     State _state{ Idling };
 
     std::shared_ptr<Mesh> _mesh;
-    std::shared_ptr<Camera> _point_of_view;
+    std::shared_ptr<CameraMatrices> _point_of_view;
     glm::vec2 _target;
 
-    int _update_request{ 0 };
-    int _update_rate{ 8 };
+    float _frame_time{ 0.0f };
+    float _animation_frame_time{ 8.0f / 60.0f };
 
     std::shared_ptr<ES2Texture> _texture;
     unsigned int _texture_frame{ 0 };
@@ -315,113 +1618,715 @@ private:
     std::shared_ptr<Gun> _gun;
 };
 
-[[noreturn]]
-int main(int argc, char** argv)
+// Reads one LOD of a file written by mesh_converter. The file is memory
+// mapped and its records are decoded in one pass into the vectors
+// ES2Geometry is built from; ES2Geometry owns its data, so this single copy
+// is the only one. asr vertices have no tangents, so those are returned
+// next to them, one (x, y, z, bitangent sign) per vertex. Returns false when the file is missing or invalid, so
+// callers can fall back to the generators.
+static bool load_mesh_file(
+    const std::string& path, unsigned int lod,
+    std::vector<unsigned int>& indices, std::vector<Vertex>& vertices, std::vector<glm::vec4>& tangents
+)
 {
-    // Window
+    using namespace mesh_format;
 
-    auto window = std::make_shared<ES2SDLWindow>("asr", 0, 0);
-    window->set_capture_mouse_enabled(true);
-    window->set_relative_mouse_mode_enabled(true);
+    MappedFile file(path);
+    const Header* header = validate_mesh_file(file.get_data(), file.get_size());
+    if (header == nullptr) {
+        return false;
+    }
+
+    const auto* lods = reinterpret_cast<const LodRange*>(file.get_data() + header->lods_offset);
+    const LodRange& range = lods[std::min(lod, header->lod_count - 1U)];
+
+    const auto* file_indices = reinterpret_cast<const uint32_t*>(file.get_data() + header->indices_offset);
+    indices.assign(file_indices + range.first_index, file_indices + range.first_index + range.index_count);
+    for (auto index : indices) {
+        if (index >= header->vertex_count) {
+            return false;
+        }
+    }
+
+    const uint8_t* records = file.get_data() + header->vertices_offset;
+    bool quantized = (header->flags & MESH_FLAG_QUANTIZED) != 0U;
+    vertices.resize(header->vertex_count);
+    tangents.resize(header->vertex_count);
+    for (auto i = 0U; i < header->vertex_count; ++i) {
+        auto& vertex = vertices[i];
+        // The files store no colors, white leaves the material colors as they are.
+        vertex.color = glm::vec4{ 1.0f };
+        if (quantized) {
+            QuantizedVertex record;
+            std::memcpy(&record, records + static_cast<size_t>(i) * sizeof(QuantizedVertex), sizeof(QuantizedVertex));
+            for (auto axis = 0U; axis < 3U; ++axis) {
+                vertex.position[axis] = dequantize_unorm16(record.position[axis], header->position_min[axis], header->position_max[axis]);
+                vertex.normal[axis] = dequantize_snorm8(record.normal[axis]);
+            }
+            for (auto axis = 0U; axis < 4U; ++axis) {
+                tangents[i][axis] = dequantize_snorm8(record.tangent[axis]);
+            }
+            for (auto axis = 0U; axis < 2U; ++axis) {
+                vertex.texture_coordinates[axis] = dequantize_unorm16(
+                    record.texture_coordinates[axis], header->texture_coordinates_min[axis], header->texture_coordinates_max[axis]
+                );
+            }
+        } else {
+            FullVertex record;
+            std::memcpy(&record, records + static_cast<size_t>(i) * sizeof(FullVertex), sizeof(FullVertex));
+            vertex.position = glm::vec3{ record.position[0], record.position[1], record.position[2] };
+            vertex.normal = glm::vec3{ record.normal[0], record.normal[1], record.normal[2] };
+            vertex.texture_coordinates.x = record.texture_coordinates[0];
+            vertex.texture_coordinates.y = record.texture_coordinates[1];
+            tangents[i] = glm::vec4{ record.tangent[0], record.tangent[1], record.tangent[2], record.tangent[3] };
+        }
+    }
+
+    return true;
+}
+
+[[nodiscard]] static LevelDescription make_default_level_description()
+{
+    using Description = LevelDescription;
 
-    // Column
+    Description level;
 
-    auto [column_indices, column_vertices] = geometry_generators::generate_box_geometry_data(1.0f, 9.0f, 1.0f, 5, 5, 5);
-    auto column_geometry = std::make_shared<ES2Geometry>(column_indices, column_vertices);
-    auto column_material = std::make_shared<ES2PhongMaterial>();
+    level.meshes = {
+        Description::MeshDescription{ Description::BoxShape, glm::vec3{ 1.0f, 9.0f, 1.0f }, glm::uvec3{ 5U }, "data/meshes/column.mesh" },
+        // The baked lighting needs vertices to vary across. The ground
+        // carries the shadows of the columns, the walls only the falloff of
+        // the lights.
+        Description::MeshDescription{ Description::PlaneShape, glm::vec3{ 50.0f, 50.0f, 0.0f }, glm::uvec3{ 50U }, "" },
+        Description::MeshDescription{ Description::BoxShape, glm::vec3{ 50.0f }, glm::uvec3{ 25U }, "" }
+    };
 
-    column_material->set_specular_exponent(1.0f);
-    column_material->set_face_culling_enabled(false);
+    Description::MaterialDescription column_material;
+    column_material.flags = Description::SetSpecularExponent | Description::SetFaceCulling;
+    column_material.specular_exponent = 1.0f;
+    column_material.face_culling_enabled = 0;
+    column_material.texture = "data/images/column_texture.png";
+
+    Description::MaterialDescription ground_material;
+    ground_material.flags =
+        Description::SetSpecularExponent | Description::SetSpecularColor | Description::SetDiffuseColor | Description::BakedLighting;
+    ground_material.specular_exponent = 1.0f;
+    ground_material.specular_color = glm::vec3{ 0.0f };
+    ground_material.diffuse_color = glm::vec4{ 1.0f };
+    ground_material.texture = "data/images/ground_texture.png";
+    ground_material.normal_texture = "data/images/ground_normal.png";
+
+    Description::MaterialDescription room_material;
+    room_material.flags =
+        Description::SetFaceCulling | Description::SetSpecularExponent | Description::SetSpecularColor | Description::SetDiffuseColor | Description::SetAmbientColor |
+        Description::BakedLighting;
+    room_material.face_culling_enabled = 0;
+    room_material.specular_exponent = 0.5f;
+    room_material.specular_color = glm::vec3{ 0.0f };
+    room_material.diffuse_color = glm::vec4{ 0.5f };
+    room_material.ambient_color = glm::vec3{ 0.1f };
+    room_material.texture = "data/images/room_texture.png";
+    room_material.normal_texture = "data/images/room_normal.png";
+
+    level.materials = { column_material, ground_material, room_material };
+
+    uint32_t column_flags{ Description::StaticBatchObject | Description::OccluderObject };
+    level.objects = {
+        Description::ObjectDescription{ 0, 0, column_flags, glm::vec3{ 22.0f, 2.0f, -22.0f }, glm::vec3{ 0.0f } },
+        Description::ObjectDescription{ 0, 0, column_flags, glm::vec3{ -22.0f, 2.0f, -22.0f }, glm::vec3{ 0.0f } },
+        Description::ObjectDescription{ 0, 0, column_flags, glm::vec3{ 22.0f, 2.0f, 22.0f }, glm::vec3{ 0.0f } },
+        Description::ObjectDescription{ 0, 0, column_flags, glm::vec3{ -22.0f, 2.0f, 22.0f }, glm::vec3{ 0.0f } },
+        Description::ObjectDescription{ 1, 1, 0, glm::vec3{ 0.0f, -2.5f, 0.0f }, glm::vec3{ static_cast<float>(-M_PI / 2.0), 0.0f, 0.0f } },
+        Description::ObjectDescription{ 2, 2, 0, glm::vec3{ 0.0f }, glm::vec3{ 0.0f } }
+    };
 
-    auto [image1_data, image1_width, image1_height, image1_channels] = file_utilities::read_image_file("data/images/column_texture.png");
-    auto [image1_normals_data, image1_normals_width, image1_normals_height, image1_normals_channels] = file_utilities::read_image_file("data/images/ground_normal.png");
+    for (const auto& light_position : {
+            glm::vec3{ -22.0f, 7.0f, 22.0f }, glm::vec3{ 22.0f, 7.0f, 22.0f },
+            glm::vec3{ 22.0f, 7.0f, -22.0f }, glm::vec3{ -22.0f, 7.0f, -22.0f } }) {
+        level.lights.push_back(Description::LightDescription{ light_position, glm::vec3{ 1.0f }, 700.0f, 0.0f, 0.2f, 0.8f, 1 });
+    }
 
-    auto column_texture = std::make_shared<ES2Texture>(image1_data, image1_width, image1_height, image1_channels);
-    auto column_texture1_normals = std::make_shared<ES2Texture>(image1_normals_data, image1_normals_width, image1_normals_height, image1_normals_channels);
+    level.enemies = { Description::EnemyDescription{ glm::vec3{ -10.0f, 1.5f, 0.0f }, 9.0f, 3.0f } };
+    level.enemy_sprite_file = "data/images/boss.png";
+    level.enemy_sprite_frames = 12;
+    level.enemy_dying_first_sprite_frame = 6;
 
-    column_material->set_texture_1(column_texture);
-    // column_material->set_texture_1_normals(column_texture1_normals);
+    level.camera_position = glm::vec3{ 0.0f, 0.0f, 20.0f };
+    level.camera_zoom = 3.0f;
 
-    // column_material->set_ambient_color(glm::vec3{ 1.0f,1.0f,1.0f });
-    auto column1 = std::make_shared<Mesh>(column_geometry, column_material);
-    auto column2 = std::make_shared<Mesh>(column_geometry, column_material);
-    auto column3 = std::make_shared<Mesh>(column_geometry, column_material);
-    auto column4 = std::make_shared<Mesh>(column_geometry, column_material);
+    return level;
+}
 
-    column1->set_position(glm::vec3(22.0f, 2.0f, -22.0f));
-    column2->set_position(glm::vec3(-22.0f, 2.0f, -22.0f));
-    column3->set_position(glm::vec3(22.0f, 2.0f, 22.0f));
-    column4->set_position(glm::vec3(-22.0f, 2.0f, 22.0f));
+// Bakes the static point lights of a level into vertex colors. asr vertices
+// have a single set of texture coordinates and its materials a single color
+// texture, so there is no room for a lightmap; the lit color is stored per
+// vertex of finely tessellated meshes instead and ES2ConstantMaterial
+// multiplies it with the texture. The lighting model is the one of
+// ES2PhongMaterial without its view dependent specular term, and shadows come
+// from segments between each vertex and each light tested against the
+// occluder boxes. Normal maps are applied through the precomputed tangent
+// frames of the mesh. They are sampled once per vertex, so the detail finer
+// than the vertex spacing would alias: the sample is taken from a box filtered
+// level of the map whose texels are as far apart as the vertices. Vertices
+// are baked in parallel on the jobs.
+class LightBaker {
+public:
+    typedef LevelDescription::LightDescription light_type;
+    typedef LevelDescription::MaterialDescription material_type;
 
+    struct Statistics {
+        size_t baked_vertices{ 0 };
+        size_t shadow_rays{ 0 };
+        size_t shadowed_rays{ 0 };
+    };
 
-    // Room Ground
+    LightBaker(const std::vector<light_type>& lights, JobSystem& jobs) : _lights{ lights }, _jobs{ jobs }
+    { }
 
-    auto [room_ground_indices, room_ground_vertices] = geometry_generators::generate_plane_geometry_data(50, 50, 1, 1);
-    auto [room_wall1_indices, room_wall1_vertices] = geometry_generators::generate_plane_geometry_data(50, 11, 1, 1);
+    void add_occluder_box(const glm::vec3& min, const glm::vec3& max)
+    {
+        _occluders.emplace_back(min, max);
+    }
 
+    // Replaces the colors of the vertices with their lit colors. Positions,
+    // normals and tangents are in the space of the model matrix. The normal
+    // map is optional.
+    void bake(
+        std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, const std::vector<glm::vec4>& tangents,
+        const glm::mat4& model_matrix, const material_type& material, const TextureStreamer::image_data_type* normal_map
+    )
+    {
+        glm::mat3 tangent_matrix = glm::mat3(model_matrix);
+        glm::mat3 normal_matrix = glm::transpose(glm::inverse(tangent_matrix));
+        const std::vector<NormalMapLevel>* normal_map_levels{ nullptr };
+        float normal_map_level{ 0.0f };
+        if (normal_map != nullptr && tangents.size() == vertices.size()) {
+            normal_map_levels = &_get_normal_map_levels(*normal_map);
+            if (normal_map_levels->empty()) {
+                normal_map_levels = nullptr;
+            } else {
+                const auto& base = normal_map_levels->front();
+                float spacing = _texel_spacing(vertices, indices, base.width, base.height);
+                normal_map_level = std::min(
+                    std::log2(std::max(spacing, 1.0f)), static_cast<float>(normal_map_levels->size() - 1)
+                );
+            }
+        }
+        glm::vec3 ambient_color = (material.flags & LevelDescription::SetAmbientColor) ? material.ambient_color : glm::vec3{ 0.0f };
+        glm::vec4 diffuse_color = (material.flags & LevelDescription::SetDiffuseColor) ? material.diffuse_color : glm::vec4{ 1.0f };
+
+        std::atomic<size_t> shadow_rays{ 0 }, shadowed_rays{ 0 };
+        _jobs.parallel_for(vertices.size(), LIGHT_BAKING_BATCH_SIZE, [&](size_t begin, size_t end) {
+            size_t batch_shadow_rays{ 0 }, batch_shadowed_rays{ 0 };
+            for (size_t i = begin; i < end; ++i) {
+                auto& vertex = vertices[i];
+                glm::vec3 position = glm::vec3(model_matrix * glm::vec4(vertex.position, 1.0f));
+                glm::vec3 normal = glm::normalize(normal_matrix * vertex.normal);
+                if (normal_map_levels != nullptr) {
+                    glm::vec3 tangent = glm::normalize(tangent_matrix * glm::vec3(tangents[i]));
+                    glm::vec3 bitangent = tangents[i].w * glm::cross(normal, tangent);
+                    glm::vec3 mapped = _sample_normal_map(*normal_map_levels, vertex.texture_coordinates, normal_map_level);
+                    normal = glm::normalize(tangent * mapped.x + bitangent * mapped.y + normal * mapped.z);
+                }
 
-    auto room_ground_geometry = std::make_shared<ES2Geometry>(room_ground_indices, room_ground_vertices);
-    auto room_ground_material = std::make_shared<ES2PhongMaterial>();
+                glm::vec3 color = ambient_color;
+                for (const auto& light : _lights) {
+                    glm::vec3 light_vector = light.position - position;
+                    float distance = glm::length(light_vector);
+                    if (distance <= 0.0f) {
+                        continue;
+                    }
+                    light_vector /= distance;
+
+                    // Two sided lights light whichever side of the surface faces them.
+                    float n_dot_l = glm::dot(normal, light_vector);
+                    glm::vec3 side_normal = n_dot_l < 0.0f && light.two_sided != 0 ? -normal : normal;
+                    n_dot_l = light.two_sided != 0 ? std::abs(n_dot_l) : std::max(n_dot_l, 0.0f);
+
+                    float attenuation = light.intensity / (
+                        light.constant_attenuation + light.linear_attenuation * distance + light.quadratic_attenuation * distance * distance
+                    );
+                    glm::vec3 diffuse_term = n_dot_l * glm::vec3(diffuse_color);
+
+                    if (n_dot_l > 0.0f) {
+                        ++batch_shadow_rays;
+                        glm::vec3 origin = position + (side_normal + light_vector) * LIGHT_BAKING_SHADOW_BIAS;
+                        if (_is_shadowed(origin, light.position)) {
+                            ++batch_shadowed_rays;
+                            diffuse_term = glm::vec3{ 0.0f };
+                        }
+                    }
+
+                    color += attenuation * (light.ambient_color + diffuse_term);
+                }
 
-    room_ground_material->set_specular_exponent(1.0f);
-    room_ground_material->set_specular_color(glm::vec3{ 0.0f });
-    room_ground_material->set_diffuse_color(glm::vec4{ 1.0f });
+                vertex.color = glm::vec4{ color, diffuse_color.a };
+            }
+            shadow_rays += batch_shadow_rays;
+            shadowed_rays += batch_shadowed_rays;
+        });
 
-    auto [image_data, image_width, image_height, image_channels] = file_utilities::read_image_file("data/images/ground_texture.png");
-    auto [image_normals_data, image_normals_width, image_normals_height, image_normals_channels] = file_utilities::read_image_file("data/images/ground_normal.png");
+        _statistics.baked_vertices += vertices.size();
+        _statistics.shadow_rays += shadow_rays;
+        _statistics.shadowed_rays += shadowed_rays;
+    }
 
-    auto ground_texture = std::make_shared<ES2Texture>(image_data, image_width, image_height, image_channels);
-    auto ground_texture_normals = std::make_shared<ES2Texture>(image_normals_data, image_normals_width, image_normals_height, image_normals_channels);
+    [[nodiscard]] const Statistics& get_statistics() const
+    {
+        return _statistics;
+    }
 
-    room_ground_material->set_texture_1(ground_texture);
-    room_ground_material->set_texture_1_normals(ground_texture_normals);
+private:
+    std::vector<light_type> _lights;
+    JobSystem& _jobs;
 
-    auto room_ground = std::make_shared<Mesh>(room_ground_geometry, room_ground_material);
-    room_ground->set_position(glm::vec3(0.0f, -2.5f, 0.0f));
-    room_ground->set_rotation(glm::vec3(-M_PI / 2.0f, 0.0f, 0.0f));
+    std::vector<std::pair<glm::vec3, glm::vec3>> _occluders;
+    Statistics _statistics;
 
-    // Walls & Ceiling
+    // One level of a decoded normal map. The normals are averaged, not
+    // renormalized, so that a bumpy area flattens in the coarser levels.
+    struct NormalMapLevel {
+        int width{ 0 }, height{ 0 };
+        std::vector<glm::vec3> normals;
+    };
 
-    auto [room_indices, room_vertices] = geometry_generators::generate_box_geometry_data(50.0f, 50.0f, 50.0f, 5, 5, 5);
+    std::vector<std::pair<const TextureStreamer::image_data_type*, std::vector<NormalMapLevel>>> _normal_maps;
 
-    auto room_geometry = std::make_shared<ES2Geometry>(room_indices, room_vertices);
-    auto room_material = std::make_shared<ES2PhongMaterial>();
+    // Decodes the normal map and box filters it down to a single texel, once
+    // for all of the meshes that use it.
+    const std::vector<NormalMapLevel>& _get_normal_map_levels(const TextureStreamer::image_data_type& image)
+    {
+        for (const auto& [normal_map, levels] : _normal_maps) {
+            if (normal_map == &image) {
+                return levels;
+            }
+        }
 
-    room_material->set_face_culling_enabled(false);
-    room_material->set_specular_exponent(0.5f);
-    room_material->set_specular_color(glm::vec3{ 0.0f });
-    room_material->set_diffuse_color(glm::vec4{ 0.5f });
+        std::vector<NormalMapLevel> levels;
+        const auto& [data, image_width, image_height, image_channels] = image;
+        auto width = static_cast<int>(image_width), height = static_cast<int>(image_height), channels = static_cast<int>(image_channels);
+        if (width > 0 && height > 0 && channels >= 3) {
+            NormalMapLevel base{ width, height, std::vector<glm::vec3>(static_cast<size_t>(width) * static_cast<size_t>(height)) };
+            for (size_t texel = 0; texel < base.normals.size(); ++texel) {
+                size_t offset = texel * static_cast<size_t>(channels);
+                base.normals[texel] = glm::vec3{
+                    static_cast<float>(data[offset]), static_cast<float>(data[offset + 1]), static_cast<float>(data[offset + 2])
+                } / 255.0f * 2.0f - 1.0f;
+            }
+            levels.push_back(std::move(base));
+
+            while (levels.back().width > 1 || levels.back().height > 1) {
+                const auto& finer = levels.back();
+                NormalMapLevel level{ std::max(finer.width / 2, 1), std::max(finer.height / 2, 1), {} };
+                level.normals.resize(static_cast<size_t>(level.width) * static_cast<size_t>(level.height));
+                for (int row = 0; row < level.height; ++row) {
+                    for (int column = 0; column < level.width; ++column) {
+                        glm::vec3 sum{ 0.0f };
+                        for (int y = 0; y < 2; ++y) {
+                            for (int x = 0; x < 2; ++x) {
+                                sum += _texel(finer, column * 2 + x, row * 2 + y);
+                            }
+                        }
+                        level.normals[static_cast<size_t>(row) * static_cast<size_t>(level.width) + static_cast<size_t>(column)] = sum / 4.0f;
+                    }
+                }
+                levels.push_back(std::move(level));
+            }
+        }
 
-    auto [image2_data, image2_width, image2_height, image2_channels] = file_utilities::read_image_file("data/images/room_texture.png");
-    auto [image2_normals_data, image2_normals_width, image2_normals_height, image2_normals_channels] = file_utilities::read_image_file("data/images/room_normal.png");
+        _normal_maps.emplace_back(&image, std::move(levels));
+        return _normal_maps.back().second;
+    }
 
-    auto wall_texture1 = std::make_shared<ES2Texture>(image2_data, image2_width, image2_height, image2_channels);
-    auto wall_texture1_normals = std::make_shared<ES2Texture>(image2_normals_data, image2_normals_width, image2_normals_height, image2_normals_channels);
+    // The average length of the triangle edges in texels of a width by height texture.
+    [[nodiscard]] static float _texel_spacing(
+        const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, int width, int height
+    )
+    {
+        glm::vec2 size{ static_cast<float>(width), static_cast<float>(height) };
+        float length{ 0.0f };
+        size_t edges{ 0 };
+        for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+            for (size_t edge = 0; edge < 3; ++edge) {
+                unsigned int from = indices[i + edge], to = indices[i + (edge + 1) % 3];
+                if (from < vertices.size() && to < vertices.size()) {
+                    length += glm::length((vertices[to].texture_coordinates - vertices[from].texture_coordinates) * size);
+                    ++edges;
+                }
+            }
+        }
 
-    room_material->set_texture_1(wall_texture1);
-    room_material->set_texture_1_normals(wall_texture1_normals);
+        return edges > 0 ? length / static_cast<float>(edges) : 0.0f;
+    }
 
-    room_material->set_ambient_color(glm::vec3{ 0.1f });
-    auto room = std::make_shared<Mesh>(room_geometry, room_material);
-    room->set_position(glm::vec3(0.0f, 0.0f, 0.0f));
+    // Repeating texel lookup.
+    [[nodiscard]] static const glm::vec3& _texel(const NormalMapLevel& level, int column, int row)
+    {
+        column = (column % level.width + level.width) % level.width;
+        row = (row % level.height + level.height) % level.height;
+        return level.normals[static_cast<size_t>(row) * static_cast<size_t>(level.width) + static_cast<size_t>(column)];
+    }
 
-    // Monsters
+    // Bilinear, repeating lookup of a tangent space normal in one level.
+    [[nodiscard]] static glm::vec3 _sample_level(const NormalMapLevel& level, const glm::vec2& coordinates)
+    {
+        float x = (coordinates.x - std::floor(coordinates.x)) * static_cast<float>(level.width) - 0.5f;
+        float y = (coordinates.y - std::floor(coordinates.y)) * static_cast<float>(level.height) - 0.5f;
+        float x_floor = std::floor(x), y_floor = std::floor(y);
+        float x_weight = x - x_floor, y_weight = y - y_floor;
+        auto column = static_cast<int>(x_floor), row = static_cast<int>(y_floor);
+
+        return glm::mix(
+            glm::mix(_texel(level, column, row), _texel(level, column + 1, row), x_weight),
+            glm::mix(_texel(level, column, row + 1), _texel(level, column + 1, row + 1), x_weight),
+            y_weight
+        );
+    }
 
-    float enemies_size = 9;
-    float enemies_speed = 30.0f;
-    int enemies_sprite_frames = 12;
-    int enemies_dying_first_sprite_frame = 6;
-    std::tuple enemies_sprite_data =
-        std::make_tuple(
-            "data/images/boss.png",
-            enemies_sprite_frames,
-            enemies_dying_first_sprite_frame
+    // Trilinear lookup of a tangent space normal between the two levels around level.
+    [[nodiscard]] static glm::vec3 _sample_normal_map(
+        const std::vector<NormalMapLevel>& levels, const glm::vec2& coordinates, float level
+    )
+    {
+        auto finer = static_cast<size_t>(level);
+        size_t coarser = std::min(finer + 1, levels.size() - 1);
+        glm::vec3 normal = glm::mix(
+            _sample_level(levels[finer], coordinates), _sample_level(levels[coarser], coordinates), level - static_cast<float>(finer)
         );
 
-    glm::vec3 enemy1_position{ -10.0f, 1.5f, 0.0f };
-    auto enemy1 = std::make_shared<Enemy>(enemy1_position, enemies_size, enemies_speed, enemies_sprite_data);
+        float length = glm::length(normal);
+        return length > 0.0f ? normal / length : glm::vec3{ 0.0f, 0.0f, 1.0f };
+    }
+
+    // Slab test of the segment [from, to] against every occluder box.
+    [[nodiscard]] bool _is_shadowed(const glm::vec3& from, const glm::vec3& to) const
+    {
+        glm::vec3 direction = to - from;
+        for (const auto& [min, max] : _occluders) {
+            float entry{ 0.0f }, exit{ 1.0f };
+            for (int axis = 0; axis < 3; ++axis) {
+                if (std::abs(direction[axis]) < 1e-6f) {
+                    if (from[axis] < min[axis] || from[axis] > max[axis]) {
+                        exit = -1.0f;
+                        break;
+                    }
+                    continue;
+                }
+                float inverse_direction = 1.0f / direction[axis];
+                float t0 = (min[axis] - from[axis]) * inverse_direction;
+                float t1 = (max[axis] - from[axis]) * inverse_direction;
+                if (t0 > t1) {
+                    std::swap(t0, t1);
+                }
+                entry = std::max(entry, t0);
+                exit = std::min(exit, t1);
+                if (entry > exit) {
+                    break;
+                }
+            }
+            if (entry <= exit) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+};
+
+// Objects of a level created from its description.
+struct LoadedLevel {
+    std::vector<std::shared_ptr<Object>> objects;
+    std::vector<std::unique_ptr<StaticBatch>> static_batches;
+    LightBaker::Statistics baking;
+};
+
+// Generating geometry, reading mesh files and decoding images do not touch
+// GL, so they run in parallel on the jobs first. Materials, textures and
+// geometry are then created on this thread, which owns the GL context.
+static LoadedLevel load_level(
+    const LevelDescription& description, JobSystem& jobs, TextureStreamer& texture_streamer, OcclusionCuller& occlusion
+)
+{
+    PROFILE_ZONE("load level");
+
+    typedef std::pair<std::vector<unsigned int>, std::vector<Vertex>> mesh_data_type;
+
+    std::vector<std::string> image_files;
+    auto image_index = [&image_files](const std::string& file) {
+        return static_cast<size_t>(std::find(image_files.begin(), image_files.end(), file) - image_files.begin());
+    };
+    for (const auto& material : description.materials) {
+        for (const auto* file : { &material.texture, &material.normal_texture }) {
+            if (!file->empty() && image_index(*file) == image_files.size()) {
+                image_files.push_back(*file);
+            }
+        }
+    }
+
+    std::vector<mesh_data_type> mesh_data(description.meshes.size());
+    std::vector<std::vector<glm::vec4>> mesh_tangents(description.meshes.size());
+    std::vector<TextureStreamer::image_data_type> images(image_files.size());
+    jobs.parallel_for(mesh_data.size() + images.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            if (i >= mesh_data.size()) {
+                images[i - mesh_data.size()] = file_utilities::read_image_file(image_files[i - mesh_data.size()]);
+                continue;
+            }
+
+            const auto& mesh = description.meshes[i];
+            auto& [indices, vertices] = mesh_data[i];
+            auto& tangents = mesh_tangents[i];
+            if (!mesh.file.empty() && load_mesh_file(mesh.file, 0, indices, vertices, tangents)) {
+                continue;
+            }
+            if (mesh.shape == LevelDescription::PlaneShape) {
+                std::tie(indices, vertices) = geometry_generators::generate_plane_geometry_data(
+                    mesh.size.x, mesh.size.y, mesh.segments.x, mesh.segments.y
+                );
+            } else {
+                std::tie(indices, vertices) = geometry_generators::generate_box_geometry_data(
+                    mesh.size.x, mesh.size.y, mesh.size.z, mesh.segments.x, mesh.segments.y, mesh.segments.z
+                );
+            }
+            tangents.resize(vertices.size());
+            if (!vertices.empty()) {
+                tangent_frames::compute_tangent_frames(
+                    &vertices[0].position.x, &vertices[0].normal.x, &vertices[0].texture_coordinates.x, sizeof(Vertex),
+                    vertices.size(), indices.data(), indices.size(), &tangents[0].x
+                );
+            }
+        }
+    });
+
+    LoadedLevel level;
+    LightBaker light_baker(description.lights, jobs);
+
+    std::vector<std::shared_ptr<Material>> materials;
+    std::vector<std::vector<unsigned int>> material_textures;
+    for (const auto& description_material : description.materials) {
+        std::vector<unsigned int> textures;
+        auto add_texture = [&](const std::string& file, auto bind) {
+            if (!file.empty()) {
+                textures.push_back(texture_streamer.add_texture(file, images[image_index(file)], bind));
+            }
+        };
+
+        if (description_material.is_baked()) {
+            auto material = std::make_shared<ES2ConstantMaterial>();
+            if (description_material.flags & LevelDescription::SetFaceCulling) {
+                material->set_face_culling_enabled(description_material.face_culling_enabled != 0);
+            }
+            add_texture(description_material.texture, [material](const std::shared_ptr<ES2Texture>& texture) {
+                material->set_texture_1(texture);
+            });
+
+            materials.push_back(material);
+            material_textures.push_back(std::move(textures));
+            continue;
+        }
+
+        auto material = std::make_shared<ES2PhongMaterial>();
+        if (description_material.flags & LevelDescription::SetAmbientColor) {
+            material->set_ambient_color(description_material.ambient_color);
+        }
+        if (description_material.flags & LevelDescription::SetDiffuseColor) {
+            material->set_diffuse_color(description_material.diffuse_color);
+        }
+        if (description_material.flags & LevelDescription::SetSpecularColor) {
+            material->set_specular_color(description_material.specular_color);
+        }
+        if (description_material.flags & LevelDescription::SetSpecularExponent) {
+            material->set_specular_exponent(description_material.specular_exponent);
+        }
+        if (description_material.flags & LevelDescription::SetFaceCulling) {
+            material->set_face_culling_enabled(description_material.face_culling_enabled != 0);
+        }
+        add_texture(description_material.texture, [material](const std::shared_ptr<ES2Texture>& texture) {
+            material->set_texture_1(texture);
+        });
+        add_texture(description_material.normal_texture, [material](const std::shared_ptr<ES2Texture>& texture) {
+            material->set_texture_1_normals(texture);
+        });
+
+        materials.push_back(material);
+        material_textures.push_back(std::move(textures));
+    }
+
+    std::vector<float> mesh_radii;
+    for (const auto& [indices, vertices] : mesh_data) {
+        float radius{ 0.0f };
+        for (const auto& vertex : vertices) {
+            radius = std::max(radius, glm::length(vertex.position));
+        }
+        mesh_radii.push_back(radius);
+    }
+
+    std::vector<glm::mat4> model_matrices;
+    for (const auto& object : description.objects) {
+        glm::mat4 model_matrix = transforms::make_model_matrix(object.position, object.rotation);
+        model_matrices.push_back(model_matrix);
+
+        if (object.flags & LevelDescription::OccluderObject) {
+            glm::vec3 min{ std::numeric_limits<float>::max() }, max{ std::numeric_limits<float>::lowest() };
+            for (const auto& vertex : mesh_data[object.mesh].second) {
+                glm::vec3 position = glm::vec3(model_matrix * glm::vec4(vertex.position, 1.0f));
+                min = glm::min(min, position);
+                max = glm::max(max, position);
+            }
+            occlusion.add_occluder_box(min, max);
+            light_baker.add_occluder_box(min, max);
+        }
+    }
+
+    std::vector<std::shared_ptr<ES2Geometry>> geometries(mesh_data.size());
+    std::vector<int> material_batches(materials.size(), -1);
+    std::vector<std::pair<size_t, unsigned int>> batched_objects;
+    for (size_t i = 0; i < description.objects.size(); ++i) {
+        const auto& object = description.objects[i];
+        const auto& [indices, mesh_vertices] = mesh_data[object.mesh];
+        float radius = mesh_radii[object.mesh];
+        const glm::mat4& model_matrix = model_matrices[i];
+
+        // Every instance of a baked mesh is lit differently, so it gets its
+        // own copy of the vertices.
+        const auto& material_description = description.materials[object.material];
+        bool baked = material_description.is_baked();
+        std::vector<Vertex> baked_vertices;
+        if (baked) {
+            baked_vertices = mesh_vertices;
+            const auto& normal_texture = material_description.normal_texture;
+            light_baker.bake(
+                baked_vertices, indices, mesh_tangents[object.mesh], model_matrix, material_description,
+                normal_texture.empty() ? nullptr : &images[image_index(normal_texture)]
+            );
+        }
+        const auto& vertices = baked ? baked_vertices : mesh_vertices;
+
+        if (object.flags & LevelDescription::StaticBatchObject) {
+            int& batch = material_batches[object.material];
+            if (batch < 0) {
+                batch = static_cast<int>(level.static_batches.size());
+                level.static_batches.push_back(std::make_unique<StaticBatch>(materials[object.material]));
+            }
+            unsigned int batch_object = level.static_batches[static_cast<size_t>(batch)]->add(vertices, indices, model_matrix, radius);
+            batched_objects.emplace_back(static_cast<size_t>(batch), batch_object);
+            continue;
+        }
+
+        std::shared_ptr<ES2Geometry> geometry;
+        if (baked) {
+            geometry = std::make_shared<ES2Geometry>(indices, vertices);
+        } else {
+            auto& shared_geometry = geometries[object.mesh];
+            if (shared_geometry == nullptr) {
+                shared_geometry = std::make_shared<ES2Geometry>(indices, vertices);
+            }
+            geometry = shared_geometry;
+        }
+        auto mesh = std::make_shared<Mesh>(geometry, materials[object.material]);
+        mesh->set_position(object.position);
+        mesh->set_rotation(object.rotation);
+        for (auto texture : material_textures[object.material]) {
+            texture_streamer.add_user(texture, mesh, radius);
+        }
+        level.objects.push_back(mesh);
+    }
+
+    for (auto& batch : level.static_batches) {
+        batch->build();
+        level.objects.push_back(batch->get_mesh());
+    }
+    size_t batched_object{ 0 };
+    for (const auto& object : description.objects) {
+        if ((object.flags & LevelDescription::StaticBatchObject) == 0U) {
+            continue;
+        }
+        const auto& [batch, batch_object] = batched_objects[batched_object++];
+        const auto& static_batch = *level.static_batches[batch];
+        for (auto texture : material_textures[object.material]) {
+            texture_streamer.add_user(
+                texture, static_batch.get_mesh(), static_batch.get_object_center(batch_object), static_batch.get_object_radius(batch_object)
+            );
+        }
+    }
+
+    level.baking = light_baker.get_statistics();
+
+    return level;
+}
+
+[[noreturn]]
+int main(int argc, char** argv)
+{
+    // Simulation
+
+    // With --fixed-frame-time every frame is assumed to take the given number
+    // of seconds, so benchmark runs replay the same simulation steps.
+    // --level loads a level file, --save-level writes the level in use.
+    // F9 writes the zones recorded so far to the --trace file.
+    float fixed_frame_time{ 0.0f };
+    std::string level_file, save_level_file;
+    std::string trace_file{ "game_test_trace.json" };
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::strcmp(argv[i], "--fixed-frame-time") == 0) {
+            fixed_frame_time = std::strtof(argv[i + 1], nullptr);
+        } else if (std::strcmp(argv[i], "--level") == 0) {
+            level_file = argv[i + 1];
+        } else if (std::strcmp(argv[i], "--save-level") == 0) {
+            save_level_file = argv[i + 1];
+        } else if (std::strcmp(argv[i], "--trace") == 0) {
+            trace_file = argv[i + 1];
+        }
+    }
+
+    FixedTimestep simulation(SIMULATION_STEP, SIMULATION_MAX_STEPS_PER_FRAME);
+
+    JobSystem jobs(std::max(std::thread::hardware_concurrency(), 2U) - 1U);
+    FrameGraph simulation_graph(jobs);
+    float simulation_alpha{ 0.0f };
+
+    // Window
+
+    auto window = std::make_shared<ES2SDLWindow>("asr", 0, 0);
+    window->set_capture_mouse_enabled(true);
+    window->set_relative_mouse_mode_enabled(true);
+
+    // Texture Streaming
+
+    TextureStreamer texture_streamer(TEXTURE_STREAMING_BUDGET);
+
+    // Level
+
+    LevelDescription level_description = make_default_level_description();
+    if (!level_file.empty() && !load_level_description(level_file, level_description)) {
+        std::fprintf(stderr, "Failed to load the level '%s', using the default one\n", level_file.c_str());
+    }
+    if (!save_level_file.empty() && !save_level_description(save_level_file, level_description)) {
+        std::fprintf(stderr, "Failed to save the level to '%s'\n", save_level_file.c_str());
+    }
+
+    auto level_load_start = std::chrono::high_resolution_clock::now();
+
+    OcclusionCuller occlusion;
+    LoadedLevel level = load_level(level_description, jobs, texture_streamer, occlusion);
+
+    std::chrono::duration<float, std::milli> level_load_time = std::chrono::high_resolution_clock::now() - level_load_start;
+    std::printf("Level loaded in %.1f ms\n", level_load_time.count());
+
+    // Monsters
+
+    size_t enemies_max_count = 4096;
+    std::tuple enemies_sprite_data = std::make_tuple(level_description.enemy_sprite_file, level_description.enemy_sprite_frames);
+
+    auto enemy_sprites = std::make_shared<BillboardBatch>(enemies_max_count, enemies_sprite_data);
 
-    std::vector<std::shared_ptr<Enemy>> enemies{ enemy1 };
+    float enemies_grid_cell_size = 5.0f;
+    auto enemies_grid = std::make_shared<EnemyGrid>(glm::vec2{ -25.0f }, glm::vec2{ 25.0f }, enemies_grid_cell_size);
+
+    EnemySystem enemies(jobs, enemy_sprites, enemies_grid, level_description.enemy_dying_first_sprite_frame);
+
+    for (const auto& enemy : level_description.enemies) {
+        enemies.spawn(enemy.position, enemy.size, enemy.speed);
+    }
 
     // Gun
 
@@ -435,84 +2340,57 @@ int main(int argc, char** argv)
 
     // Lamps
 
-    auto [lamp_indices, lamp_vertices] = geometry_generators::generate_sphere_geometry_data(0.2f, 20, 20);
+    auto [lamp_indices, lamp_vertices] = copy_fixed_mesh(LAMP_MESH);
     auto lamp_sphere_geometry = std::make_shared<ES2Geometry>(lamp_indices, lamp_vertices);
     auto lamp_material = std::make_shared<ES2ConstantMaterial>();
-    auto lamp1 = std::make_shared<Mesh>(lamp_sphere_geometry, lamp_material);
-    auto lamp2 = std::make_shared<Mesh>(lamp_sphere_geometry, lamp_material);
-    auto lamp3 = std::make_shared<Mesh>(lamp_sphere_geometry, lamp_material);
-    auto lamp4 = std::make_shared<Mesh>(lamp_sphere_geometry, lamp_material);
+    float lamp_radius{ 0.2f };
 
-    std::vector<std::shared_ptr<Object>> objects{ column1, column2, column3, column4, room_ground, 
-        room, enemy1->get_mesh(), gun->get_mesh()};
+    std::vector<std::shared_ptr<Object>> objects = level.objects;
+    objects.push_back(enemy_sprites->get_mesh());
+    objects.push_back(gun->get_mesh());
 
     auto scene = std::make_shared<Scene>(objects);
 
     // Point Lights
 
-    auto point_light1 = std::make_shared<PointLight>();
-    point_light1->set_intensity(700.0f);
-    point_light1->set_constant_attenuation(0.0f);
-    point_light1->set_linear_attenuation(0.2f);
-    point_light1->set_quadratic_attenuation(0.8f);
-    point_light1->set_two_sided(true);
-    point_light1->set_position(glm::vec3(-22.0f, 7.0f, 22.0f));
-    point_light1->add_child(lamp1);
-    point_light1->set_ambient_color(glm::vec3{ 1.0f });
-    scene->get_root()->add_child(point_light1);
-    scene->get_point_lights().push_back(point_light1);
-
-    auto point_light2 = std::make_shared<PointLight>();
-    point_light2->set_intensity(700.0f);
-    point_light2->set_constant_attenuation(0.0f);
-    point_light2->set_linear_attenuation(0.2f);
-    point_light2->set_quadratic_attenuation(0.8f);
-    point_light2->set_two_sided(true);
-    point_light2->set_position(glm::vec3(22.0f, 7.0f, 22.0f));
-    point_light2->add_child(lamp2);
-    point_light2->set_ambient_color(glm::vec3{ 1.0f });
-    scene->get_root()->add_child(point_light2);
-    scene->get_point_lights().push_back(point_light2);
-
-    auto point_light3 = std::make_shared<PointLight>();
-    point_light3->set_intensity(700.0f);
-    point_light3->set_constant_attenuation(0.0f);
-    point_light3->set_linear_attenuation(0.2f);
-    point_light3->set_quadratic_attenuation(0.8f);
-    point_light3->set_two_sided(true);
-    point_light3->set_position(glm::vec3(22.0f, 7.0f, -22.0f));
-    point_light3->add_child(lamp3);
-    point_light3->set_ambient_color(glm::vec3{ 1.0f });
-    scene->get_root()->add_child(point_light3);
-    scene->get_point_lights().push_back(point_light3);
-
-    auto point_light4 = std::make_shared<PointLight>();
-    point_light4->set_intensity(700.0f);
-    point_light4->set_constant_attenuation(0.0f);
-    point_light4->set_linear_attenuation(0.2f);
-    point_light4->set_quadratic_attenuation(0.8f);
-    point_light4->set_two_sided(true);
-    point_light4->set_position(glm::vec3(-22.0f, 7.0f, -22.0f));
-    point_light4->add_child(lamp4);
-    point_light4->set_ambient_color(glm::vec3{ 1.0f });
-    scene->get_root()->add_child(point_light4);
-    scene->get_point_lights().push_back(point_light4);
+    for (const auto& light : level_description.lights) {
+        auto point_light = std::make_shared<PointLight>();
+        point_light->set_intensity(light.intensity);
+        point_light->set_constant_attenuation(light.constant_attenuation);
+        point_light->set_linear_attenuation(light.linear_attenuation);
+        point_light->set_quadratic_attenuation(light.quadratic_attenuation);
+        point_light->set_two_sided(light.two_sided != 0);
+        point_light->set_position(light.position);
+        point_light->add_child(std::make_shared<Mesh>(lamp_sphere_geometry, lamp_material));
+        point_light->set_ambient_color(light.ambient_color);
+        scene->get_root()->add_child(point_light);
+        scene->get_point_lights().push_back(point_light);
+    }
 
     // Camera
 
-    auto camera = scene->get_camera();
-    camera->set_position(glm::vec3(0.0f, 0.0f, 20.0f));
-    camera->set_zoom(3.0f);
+    auto camera = std::make_shared<CameraMatrices>(
+        scene->get_camera(), static_cast<float>(window->get_width()), static_cast<float>(window->get_height())
+    );
+    camera->set_position(level_description.camera_position);
+    camera->set_zoom(level_description.camera_zoom);
 
-    enemy1->set_target(camera);
     gun->set_point_of_view(camera);
 
     // Input
 
     float walk_delta{ 0.9f };
     float sin_walk{ 0.0f };
+    bool trace_key_was_down{ false };
 
     window->set_on_late_keys_down([&](const uint8_t* keys) {
+        if (keys[SDL_SCANCODE_F9] && !trace_key_was_down) {
+            if (!Profiler::get_instance().write_chrome_trace(trace_file)) {
+                std::fprintf(stderr, "Failed to write the trace to '%s'\n", trace_file.c_str());
+            }
+        }
+        trace_key_was_down = keys[SDL_SCANCODE_F9] != 0;
+
         sin_walk += walk_delta;
 
         glm::vec4 FORWARD{ 0.0f,std::sinf(sin_walk)*0.4f, 1.0f, 0.0f };
@@ -556,13 +2434,30 @@ int main(int argc, char** argv)
 
     auto prev_frame_time = std::chrono::high_resolution_clock::now();
 
+    // The simulation of the next frame runs on the job system while the
+    // current frame is rendered. Input is handled only after the simulation
+    // jobs have finished, so callbacks never race with them.
+
+    Profiler& profiler = Profiler::get_instance();
+
     ES2Renderer renderer(scene, window);
     for (;;) {
-        window->poll();
+        profiler.end_frame();
+
+        {
+            PROFILE_ZONE("wait for simulation");
+            simulation_graph.wait();
+        }
+
+        {
+            PROFILE_ZONE("poll");
+            window->poll();
+        }
 
         auto current_frame_time = std::chrono::high_resolution_clock::now();
         std::chrono::duration<float, std::milli> time_span = current_frame_time - prev_frame_time;
-        float delta_time = time_span.count() / 1000.0f;
+        float frame_time = fixed_frame_time > 0.0f ? fixed_frame_time : time_span.count() / 1000.0f;
+        prev_frame_time = current_frame_time;
 
         GAME_IS_WON = false;
 
@@ -572,22 +2467,100 @@ int main(int argc, char** argv)
         }
         else
         {
-            for (auto& enemy : enemies) {
-                enemy->update(delta_time);
+            if (enemies.get_dead_count() == enemies.get_count())
+            {
+                showMessage("You won!");
             }
 
-            for (auto& enemy : enemies) {
-                if (enemy->get_state() == Enemy::State::Dead)
-                {
-                    showMessage("You won!");
-                }
-            }
+            PROFILE_ZONE("upload");
+            enemy_sprites->upload();
+            gun->publish();
+        }
+
+        const auto& frame_times = profiler.get_frame_times();
+        float average_frame_time{ 0.0f }, max_frame_time{ 0.0f };
+        for (float time : frame_times) {
+            average_frame_time += time;
+            max_frame_time = std::max(max_frame_time, time);
+        }
+        average_frame_time /= static_cast<float>(frame_times.size());
+        ImGui::Begin("Frame Time");
+        ImGui::PlotLines(
+            "ms", frame_times.data(), static_cast<int>(frame_times.size()), static_cast<int>(profiler.get_frame_times_offset()),
+            nullptr, 0.0f, 50.0f, ImVec2(0, 80)
+        );
+        ImGui::Text("Average %.2f ms, max %.2f ms", average_frame_time, max_frame_time);
+        ImGui::Text("F9 writes %s", trace_file.c_str());
+        ImGui::End();
+
+        const auto& occlusion_statistics = occlusion.get_statistics();
+        ImGui::Begin("Occlusion");
+        ImGui::Text("Occluders: %u of %u triangles", occlusion_statistics.rasterized_triangles, occlusion_statistics.occluder_triangles);
+        ImGui::Text("Occluded: %u of %u objects", occlusion_statistics.occluded_objects, occlusion_statistics.tested_objects);
+        ImGui::End();
+
+        if (level.baking.baked_vertices > 0) {
+            ImGui::Begin("Light Baking");
+            ImGui::Text("Baked vertices: %zu", level.baking.baked_vertices);
+            ImGui::Text("Shadow rays blocked: %zu of %zu", level.baking.shadowed_rays, level.baking.shadow_rays);
+            ImGui::End();
+        }
+
+        camera->set_viewport_size(static_cast<float>(window->get_width()), static_cast<float>(window->get_height()));
 
-            gun->update();
+        {
+            PROFILE_ZONE("texture streaming");
+            texture_streamer.update(*camera, static_cast<float>(window->get_height()));
+        }
+
+        glm::mat4 view_projection_matrix = camera->get_view_projection_matrix();
+        {
+            PROFILE_ZONE("static culling");
+            for (auto& static_batch : level.static_batches) {
+                static_batch->cull(view_projection_matrix);
+            }
+        }
 
-            prev_frame_time = current_frame_time;
+        simulation_graph.clear();
+        if (!GAME_IS_LOST) {
+            glm::vec3 camera_position = camera->get_world_position();
+            glm::vec3 camera_right = glm::vec3(camera->get_model_matrix()[0]);
+
+            auto* simulate = simulation_graph.add("simulate", [&, frame_time, camera_position] {
+                simulation_alpha = simulation.advance(frame_time, [&](float delta_time) {
+                    if (enemies.update(delta_time, camera_position)) {
+                        GAME_IS_LOST = true;
+                    }
+                    gun->update(delta_time);
+                });
+            });
+            simulation_graph.add("broadphase", [&] { enemies.update_broadphase(); }, { simulate });
+            auto* publish = simulation_graph.add("publish", [&] { enemies.publish(simulation_alpha); }, { simulate });
+            auto* occluders = simulation_graph.add("occluders", [&, view_projection_matrix] {
+                occlusion.rasterize(view_projection_matrix);
+            });
+            auto* occlusion_test = simulation_graph.add("occlusion", [&] {
+                for (auto sprite = 0U; sprite < enemy_sprites->get_sprite_count(); ++sprite) {
+                    if (!enemy_sprites->is_sprite_visible(sprite)) {
+                        continue;
+                    }
+                    glm::vec3 center = enemy_sprites->get_sprite_position(sprite);
+                    glm::vec3 half_size{ enemy_sprites->get_sprite_size(sprite) * 0.5f };
+                    enemy_sprites->set_sprite_occluded(sprite, occlusion.is_occluded(center - half_size, center + half_size));
+                }
+                // Lamps are only counted, asr meshes have no visibility switch.
+                for (const auto& point_light : scene->get_point_lights()) {
+                    glm::vec3 center = point_light->get_position();
+                    (void) occlusion.is_occluded(center - glm::vec3{ lamp_radius }, center + glm::vec3{ lamp_radius });
+                }
+            }, { publish, occluders });
+            simulation_graph.add("sprites", [&, camera_position, camera_right] {
+                enemy_sprites->build(camera_position, camera_right);
+            }, { occlusion_test });
+            simulation_graph.run();
         }
 
+        PROFILE_ZONE("render");
         renderer.render();
     }
 }
@@ -0,0 +1,262 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include "profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Work-stealing job system. Every worker owns a queue: it pushes and pops
+// its own jobs at the back and steals from the front of the others' queues
+// when it runs dry. Threads that wait for a job keep executing other jobs
+// meanwhile, so jobs may wait on jobs they spawned (see parallel_for).
+class JobSystem {
+public:
+    struct Job {
+        const char* name{ "" };
+        std::function<void()> work;
+
+        std::atomic<int> pending_dependencies{ 0 };
+        std::vector<Job*> dependents;
+        std::atomic<bool> finished{ false };
+
+        unsigned int thread{ 0 };
+        std::chrono::high_resolution_clock::time_point started, ended;
+    };
+
+    explicit JobSystem(unsigned int worker_count)
+    {
+        for (auto i = 0U; i <= worker_count; ++i) {
+            _queues.push_back(std::make_unique<Queue>());
+        }
+        for (auto i = 1U; i <= worker_count; ++i) {
+            _workers.emplace_back([this, i] { _run_worker(i); });
+        }
+    }
+
+    ~JobSystem()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_sleep_mutex);
+            _stopping = true;
+        }
+        _wake.notify_all();
+        for (auto& worker : _workers) {
+            worker.join();
+        }
+    }
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    [[nodiscard]] unsigned int get_thread_count() const
+    {
+        return static_cast<unsigned int>(_queues.size());
+    }
+
+    void submit(Job* job)
+    {
+        auto& queue = *_queues[_thread_index];
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.jobs.push_back(job);
+        }
+        ++_queued;
+        {
+            std::lock_guard<std::mutex> lock(_sleep_mutex);
+        }
+        _wake.notify_one();
+    }
+
+    void wait(const Job* job)
+    {
+        while (!job->finished.load(std::memory_order_acquire)) {
+            if (Job* next = _next_job()) {
+                _execute(next);
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    // Splits [0, count) into batches of at most batch_size and runs them as jobs.
+    template<typename Work>
+    void parallel_for(size_t count, size_t batch_size, Work&& work)
+    {
+        size_t batch_count = (count + batch_size - 1) / batch_size;
+        if (batch_count <= 1) {
+            work(size_t{ 0 }, count);
+            return;
+        }
+
+        std::deque<Job> jobs(batch_count);
+        for (size_t batch = 0; batch < batch_count; ++batch) {
+            size_t begin = batch * batch_size, end = std::min(count, begin + batch_size);
+            jobs[batch].name = "parallel_for";
+            jobs[batch].work = [&work, begin, end] { work(begin, end); };
+            submit(&jobs[batch]);
+        }
+        for (auto& job : jobs) {
+            wait(&job);
+        }
+    }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Job*> jobs;
+    };
+
+    inline static thread_local unsigned int _thread_index{ 0 };
+
+    std::vector<std::unique_ptr<Queue>> _queues;
+    std::vector<std::thread> _workers;
+
+    std::atomic<int> _queued{ 0 };
+    std::mutex _sleep_mutex;
+    std::condition_variable _wake;
+    bool _stopping{ false };
+
+    Job* _next_job()
+    {
+        {
+            auto& queue = *_queues[_thread_index];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (!queue.jobs.empty()) {
+                Job* job = queue.jobs.back();
+                queue.jobs.pop_back();
+                --_queued;
+                return job;
+            }
+        }
+
+        for (size_t i = 1; i < _queues.size(); ++i) {
+            auto& queue = *_queues[(_thread_index + i) % _queues.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (!queue.jobs.empty()) {
+                Job* job = queue.jobs.front();
+                queue.jobs.pop_front();
+                --_queued;
+                return job;
+            }
+        }
+
+        return nullptr;
+    }
+
+    void _execute(Job* job)
+    {
+        job->thread = _thread_index;
+        job->started = std::chrono::high_resolution_clock::now();
+        {
+            PROFILE_ZONE(job->name);
+            job->work();
+        }
+        job->ended = std::chrono::high_resolution_clock::now();
+
+        for (auto* dependent : job->dependents) {
+            if (--dependent->pending_dependencies == 0) {
+                submit(dependent);
+            }
+        }
+        job->finished.store(true, std::memory_order_release);
+    }
+
+    void _run_worker(unsigned int index)
+    {
+        _thread_index = index;
+
+        for (;;) {
+            if (Job* job = _next_job()) {
+                _execute(job);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(_sleep_mutex);
+            _wake.wait(lock, [this] { return _stopping || _queued.load() > 0; });
+            if (_stopping) {
+                return;
+            }
+        }
+    }
+};
+
+// Jobs of one frame and the order they have to run in. The graph is built
+// up front, then run() hands the jobs without dependencies to the job
+// system and the rest follow as their dependencies finish.
+class FrameGraph {
+public:
+    explicit FrameGraph(JobSystem& jobs) : _jobs{ jobs }
+    {
+    }
+
+    JobSystem::Job* add(
+        const char* name, std::function<void()> work, std::initializer_list<JobSystem::Job*> dependencies = {}
+    )
+    {
+        auto& job = _graph.emplace_back();
+        job.name = name;
+        job.work = std::move(work);
+        job.pending_dependencies = static_cast<int>(dependencies.size());
+        for (auto* dependency : dependencies) {
+            dependency->dependents.push_back(&job);
+        }
+
+        return &job;
+    }
+
+    void run()
+    {
+        _started = std::chrono::high_resolution_clock::now();
+        for (auto& job : _graph) {
+            if (job.pending_dependencies == 0) {
+                _jobs.submit(&job);
+            }
+        }
+    }
+
+    void wait()
+    {
+        for (auto& job : _graph) {
+            _jobs.wait(&job);
+        }
+    }
+
+    void clear()
+    {
+        _graph.clear();
+    }
+
+    [[nodiscard]] bool empty() const
+    {
+        return _graph.empty();
+    }
+
+    [[nodiscard]] const std::deque<JobSystem::Job>& get_jobs() const
+    {
+        return _graph;
+    }
+
+    [[nodiscard]] std::chrono::high_resolution_clock::time_point get_start_time() const
+    {
+        return _started;
+    }
+
+private:
+    JobSystem& _jobs;
+    std::deque<JobSystem::Job> _graph;
+    std::chrono::high_resolution_clock::time_point _started;
+};
+
+#endif
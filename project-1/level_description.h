@@ -0,0 +1,269 @@
+#ifndef LEVEL_DESCRIPTION_H
+#define LEVEL_DESCRIPTION_H
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <fstream>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Plain data a level is built from. It is saved to and loaded from binary
+// files (--save-level and --level), so levels can change without
+// recompiling; make_default_level_description() in game_test.cpp is the
+// level the game shipped with. Records without strings contain only 32 bit
+// fields, so they have no padding and are written as they are.
+struct LevelDescription {
+    enum MeshShape : uint32_t {
+        BoxShape,
+        PlaneShape
+    };
+
+    enum MaterialFlags : uint32_t {
+        SetAmbientColor = 1U << 0U,
+        SetDiffuseColor = 1U << 1U,
+        SetSpecularColor = 1U << 2U,
+        SetSpecularExponent = 1U << 3U,
+        SetFaceCulling = 1U << 4U,
+        BakedLighting = 1U << 5U
+    };
+
+    enum ObjectFlags : uint32_t {
+        StaticBatchObject = 1U << 0U,
+        OccluderObject = 1U << 1U
+    };
+
+    // A mesh file is used when it exists, the generated shape otherwise.
+    struct MeshDescription {
+        uint32_t shape{ BoxShape };
+        glm::vec3 size{ 1.0f };
+        glm::uvec3 segments{ 1U };
+        std::string file;
+
+        template<typename Archive>
+        void serialize(Archive& archive)
+        {
+            archive(shape); archive(size); archive(segments); archive(file);
+        }
+    };
+
+    // Phong materials. Properties without their flag keep the asr defaults.
+    // With BakedLighting the static lights are baked into the vertices of the
+    // objects using the material, which are then drawn unlit. The specular
+    // term depends on the view and cannot be baked, so only materials that
+    // set a black specular color are baked.
+    struct MaterialDescription {
+        uint32_t flags{ 0 };
+        glm::vec3 ambient_color{ 0.0f };
+        glm::vec4 diffuse_color{ 1.0f };
+        glm::vec3 specular_color{ 1.0f };
+        float specular_exponent{ 1.0f };
+        uint32_t face_culling_enabled{ 1 };
+        std::string texture;
+        std::string normal_texture;
+
+        template<typename Archive>
+        void serialize(Archive& archive)
+        {
+            archive(flags); archive(ambient_color); archive(diffuse_color); archive(specular_color);
+            archive(specular_exponent); archive(face_culling_enabled); archive(texture); archive(normal_texture);
+        }
+
+        [[nodiscard]] bool is_baked() const
+        {
+            return (flags & BakedLighting) != 0U && (flags & SetSpecularColor) != 0U && specular_color == glm::vec3{ 0.0f };
+        }
+    };
+
+    struct ObjectDescription {
+        uint32_t mesh;
+        uint32_t material;
+        uint32_t flags;
+        glm::vec3 position;
+        glm::vec3 rotation;
+    };
+
+    struct LightDescription {
+        glm::vec3 position;
+        glm::vec3 ambient_color;
+        float intensity;
+        float constant_attenuation;
+        float linear_attenuation;
+        float quadratic_attenuation;
+        uint32_t two_sided;
+    };
+
+    struct EnemyDescription {
+        glm::vec3 position;
+        float size;
+        float speed;
+    };
+
+    std::vector<MeshDescription> meshes;
+    std::vector<MaterialDescription> materials;
+    std::vector<ObjectDescription> objects;
+    std::vector<LightDescription> lights;
+    std::vector<EnemyDescription> enemies;
+
+    std::string enemy_sprite_file;
+    uint32_t enemy_sprite_frames{ 1 };
+    uint32_t enemy_dying_first_sprite_frame{ 0 };
+
+    glm::vec3 camera_position{ 0.0f };
+    float camera_zoom{ 1.0f };
+
+    template<typename Archive>
+    void serialize(Archive& archive)
+    {
+        archive(meshes); archive(materials); archive(objects); archive(lights); archive(enemies);
+        archive(enemy_sprite_file); archive(enemy_sprite_frames); archive(enemy_dying_first_sprite_frame);
+        archive(camera_position); archive(camera_zoom);
+    }
+};
+
+static const uint32_t LEVEL_FILE_MAGIC{ 0x4c525341U }; // "ASRL"
+static const uint32_t LEVEL_FILE_VERSION{ 1U };
+static const uint32_t LEVEL_FILE_MAX_COUNT{ 1U << 20U };
+
+template<typename T>
+struct is_vector : std::false_type { };
+
+template<typename T>
+struct is_vector<std::vector<T>> : std::true_type { };
+
+class LevelWriter {
+public:
+    explicit LevelWriter(std::ostream& output) : _output{ output }
+    { }
+
+    template<typename T>
+    void operator()(const T& value)
+    {
+        if constexpr (std::is_same_v<T, std::string>) {
+            (*this)(static_cast<uint32_t>(value.size()));
+            _output.write(value.data(), static_cast<std::streamsize>(value.size()));
+        } else if constexpr (is_vector<T>::value) {
+            (*this)(static_cast<uint32_t>(value.size()));
+            for (const auto& element : value) {
+                (*this)(element);
+            }
+        } else if constexpr (std::is_trivially_copyable_v<T>) {
+            _output.write(reinterpret_cast<const char*>(&value), sizeof(T));
+        } else {
+            // serialize() only reads the fields through a writer.
+            const_cast<T&>(value).serialize(*this);
+        }
+    }
+
+private:
+    std::ostream& _output;
+};
+
+class LevelReader {
+public:
+    explicit LevelReader(std::istream& input) : _input{ input }
+    { }
+
+    [[nodiscard]] bool is_good() const
+    {
+        return _good && _input.good();
+    }
+
+    template<typename T>
+    void operator()(T& value)
+    {
+        if (!is_good()) {
+            return;
+        }
+
+        if constexpr (std::is_same_v<T, std::string>) {
+            uint32_t size{ 0 };
+            (*this)(size);
+            if (!_check_count(size)) {
+                return;
+            }
+            value.resize(size);
+            _input.read(value.data(), static_cast<std::streamsize>(size));
+        } else if constexpr (is_vector<T>::value) {
+            uint32_t size{ 0 };
+            (*this)(size);
+            if (!_check_count(size)) {
+                return;
+            }
+            value.resize(size);
+            for (auto& element : value) {
+                (*this)(element);
+            }
+        } else if constexpr (std::is_trivially_copyable_v<T>) {
+            _input.read(reinterpret_cast<char*>(&value), sizeof(T));
+        } else {
+            value.serialize(*this);
+        }
+    }
+
+private:
+    std::istream& _input;
+    bool _good{ true };
+
+    bool _check_count(uint32_t count)
+    {
+        _good = _good && count <= LEVEL_FILE_MAX_COUNT;
+        return _good;
+    }
+};
+
+inline bool save_level_description(const std::string& file, const LevelDescription& level)
+{
+    std::ofstream output(file, std::ios::binary);
+    LevelWriter writer(output);
+    writer(LEVEL_FILE_MAGIC);
+    writer(LEVEL_FILE_VERSION);
+    writer(level);
+
+    return output.good();
+}
+
+inline bool load_level_description(const std::string& file, LevelDescription& level)
+{
+    std::ifstream input(file, std::ios::binary);
+    LevelReader reader(input);
+    uint32_t magic{ 0 }, version{ 0 };
+    reader(magic);
+    reader(version);
+    if (!reader.is_good() || magic != LEVEL_FILE_MAGIC || version != LEVEL_FILE_VERSION) {
+        return false;
+    }
+
+    LevelDescription loaded;
+    reader(loaded);
+    if (!reader.is_good()) {
+        return false;
+    }
+    for (const auto& object : loaded.objects) {
+        if (object.mesh >= loaded.meshes.size() || object.material >= loaded.materials.size()) {
+            return false;
+        }
+    }
+    // The generators divide by the segment counts, a plane using only two.
+    for (const auto& mesh : loaded.meshes) {
+        bool plane{ mesh.shape == LevelDescription::PlaneShape };
+        if (mesh.segments.x == 0 || mesh.segments.y == 0 || (!plane && mesh.segments.z == 0)) {
+            return false;
+        }
+    }
+    // Living enemies cycle through the frames before the first dying one.
+    if (loaded.enemy_sprite_frames == 0 ||
+        loaded.enemy_dying_first_sprite_frame == 0 ||
+        loaded.enemy_dying_first_sprite_frame >= loaded.enemy_sprite_frames) {
+        return false;
+    }
+    level = std::move(loaded);
+
+    return true;
+}
+
+#endif
@@ -0,0 +1,266 @@
+#include "mesh_format.h"
+#include "tangent_frames.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+// Converts Wavefront OBJ files into the binary mesh format of mesh_format.h.
+//
+//     mesh_converter [--quantize] output.mesh lod0.obj[@max_distance] [lod1.obj[@max_distance] ...]
+//
+// Every input file becomes one LOD, from the most to the least detailed. The
+// last LOD is used at any distance unless a distance is given for it.
+
+using namespace mesh_format;
+
+struct ImportedMesh {
+    std::vector<FullVertex> vertices;
+    std::vector<uint32_t> indices;
+};
+
+// OBJ indices start at 1, negative ones count back from the last element.
+static int resolve_obj_index(const std::string& token, size_t count)
+{
+    if (token.empty()) {
+        return -1;
+    }
+    int index = std::atoi(token.c_str());
+    if (index < 0) {
+        index += static_cast<int>(count);
+    } else {
+        --index;
+    }
+
+    return index >= 0 && static_cast<size_t>(index) < count ? index : -1;
+}
+
+static bool import_obj(const std::string& file, ImportedMesh& mesh)
+{
+    std::ifstream input(file);
+    if (!input) {
+        std::cerr << "Failed to open '" << file << "'" << std::endl;
+        return false;
+    }
+
+    std::vector<std::array<float, 3>> positions, normals;
+    std::vector<std::array<float, 2>> texture_coordinates;
+    std::map<std::tuple<int, int, int>, uint32_t> vertex_indices;
+
+    std::string line;
+    while (std::getline(input, line)) {
+        std::istringstream stream(line);
+        std::string type;
+        stream >> type;
+
+        if (type == "v") {
+            std::array<float, 3> position{};
+            stream >> position[0] >> position[1] >> position[2];
+            positions.push_back(position);
+        } else if (type == "vn") {
+            std::array<float, 3> normal{};
+            stream >> normal[0] >> normal[1] >> normal[2];
+            normals.push_back(normal);
+        } else if (type == "vt") {
+            std::array<float, 2> coordinates{};
+            stream >> coordinates[0] >> coordinates[1];
+            texture_coordinates.push_back(coordinates);
+        } else if (type == "f") {
+            std::vector<uint32_t> polygon;
+            std::string corner;
+            while (stream >> corner) {
+                std::string tokens[3];
+                size_t token{ 0 };
+                for (char c : corner) {
+                    if (c == '/') {
+                        if (++token == 3) {
+                            break;
+                        }
+                    } else {
+                        tokens[token] += c;
+                    }
+                }
+
+                auto key = std::make_tuple(
+                    resolve_obj_index(tokens[0], positions.size()),
+                    resolve_obj_index(tokens[1], texture_coordinates.size()),
+                    resolve_obj_index(tokens[2], normals.size())
+                );
+                if (std::get<0>(key) < 0) {
+                    std::cerr << "Invalid face in '" << file << "': " << line << std::endl;
+                    return false;
+                }
+
+                auto found = vertex_indices.find(key);
+                if (found == vertex_indices.end()) {
+                    FullVertex vertex{};
+                    const auto& position = positions[static_cast<size_t>(std::get<0>(key))];
+                    std::copy(position.begin(), position.end(), vertex.position);
+                    if (std::get<1>(key) >= 0) {
+                        const auto& coordinates = texture_coordinates[static_cast<size_t>(std::get<1>(key))];
+                        std::copy(coordinates.begin(), coordinates.end(), vertex.texture_coordinates);
+                    }
+                    if (std::get<2>(key) >= 0) {
+                        const auto& normal = normals[static_cast<size_t>(std::get<2>(key))];
+                        std::copy(normal.begin(), normal.end(), vertex.normal);
+                    }
+                    found = vertex_indices.emplace(key, static_cast<uint32_t>(mesh.vertices.size())).first;
+                    mesh.vertices.push_back(vertex);
+                }
+                polygon.push_back(found->second);
+            }
+
+            for (size_t i = 1; i + 1 < polygon.size(); ++i) {
+                mesh.indices.insert(mesh.indices.end(), { polygon[0], polygon[i], polygon[i + 1] });
+            }
+        }
+    }
+
+    return true;
+}
+
+static uint16_t quantize_unorm16(float value, float min, float max)
+{
+    float normalized = max > min ? (value - min) / (max - min) : 0.0f;
+    return static_cast<uint16_t>(std::lround(std::clamp(normalized, 0.0f, 1.0f) * 65535.0f));
+}
+
+static int8_t quantize_snorm8(float value)
+{
+    return static_cast<int8_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * 127.0f));
+}
+
+int main(int argc, char** argv)
+{
+    bool quantize{ false };
+    std::vector<std::string> arguments;
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "--quantize") {
+            quantize = true;
+        } else {
+            arguments.emplace_back(argv[i]);
+        }
+    }
+    if (arguments.size() < 2) {
+        std::cerr << "Usage: " << argv[0] << " [--quantize] output.mesh lod0.obj[@max_distance] [lod1.obj[@max_distance] ...]" << std::endl;
+        return 1;
+    }
+
+    std::vector<FullVertex> vertices;
+    std::vector<uint32_t> indices;
+    std::vector<LodRange> lods;
+    for (size_t i = 1; i < arguments.size(); ++i) {
+        std::string file = arguments[i];
+        float max_distance{ std::numeric_limits<float>::max() };
+        size_t separator = file.rfind('@');
+        if (separator != std::string::npos) {
+            max_distance = std::strtof(file.c_str() + separator + 1, nullptr);
+            file.resize(separator);
+        }
+
+        ImportedMesh mesh;
+        if (!import_obj(file, mesh)) {
+            return 1;
+        }
+        if (!mesh.vertices.empty()) {
+            std::vector<float> tangents(mesh.vertices.size() * 4U);
+            tangent_frames::compute_tangent_frames(
+                mesh.vertices[0].position, mesh.vertices[0].normal, mesh.vertices[0].texture_coordinates, sizeof(FullVertex),
+                mesh.vertices.size(), mesh.indices.data(), mesh.indices.size(), tangents.data()
+            );
+            for (size_t vertex = 0; vertex < mesh.vertices.size(); ++vertex) {
+                std::copy_n(tangents.data() + vertex * 4U, 4, mesh.vertices[vertex].tangent);
+            }
+        }
+
+        auto first_vertex = static_cast<uint32_t>(vertices.size());
+        lods.push_back(LodRange{ static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(mesh.indices.size()), max_distance, 0 });
+        vertices.insert(vertices.end(), mesh.vertices.begin(), mesh.vertices.end());
+        for (auto index : mesh.indices) {
+            indices.push_back(first_vertex + index);
+        }
+    }
+
+    Header header{};
+    header.magic = MESH_MAGIC;
+    header.version = MESH_VERSION;
+    header.flags = quantize ? MESH_FLAG_QUANTIZED : 0U;
+    header.vertex_stride = static_cast<uint32_t>(quantize ? sizeof(QuantizedVertex) : sizeof(FullVertex));
+    header.vertex_count = static_cast<uint32_t>(vertices.size());
+    header.index_count = static_cast<uint32_t>(indices.size());
+    header.lod_count = static_cast<uint32_t>(lods.size());
+
+    for (auto axis = 0U; axis < 3U; ++axis) {
+        header.position_min[axis] = std::numeric_limits<float>::max();
+        header.position_max[axis] = std::numeric_limits<float>::lowest();
+    }
+    for (auto axis = 0U; axis < 2U; ++axis) {
+        header.texture_coordinates_min[axis] = std::numeric_limits<float>::max();
+        header.texture_coordinates_max[axis] = std::numeric_limits<float>::lowest();
+    }
+    for (const auto& vertex : vertices) {
+        for (auto axis = 0U; axis < 3U; ++axis) {
+            header.position_min[axis] = std::min(header.position_min[axis], vertex.position[axis]);
+            header.position_max[axis] = std::max(header.position_max[axis], vertex.position[axis]);
+        }
+        for (auto axis = 0U; axis < 2U; ++axis) {
+            header.texture_coordinates_min[axis] = std::min(header.texture_coordinates_min[axis], vertex.texture_coordinates[axis]);
+            header.texture_coordinates_max[axis] = std::max(header.texture_coordinates_max[axis], vertex.texture_coordinates[axis]);
+        }
+    }
+
+    header.vertices_offset = align_blob_offset(sizeof(Header));
+    header.indices_offset = align_blob_offset(header.vertices_offset + static_cast<uint64_t>(header.vertex_count) * header.vertex_stride);
+    header.lods_offset = align_blob_offset(header.indices_offset + static_cast<uint64_t>(header.index_count) * sizeof(uint32_t));
+    header.file_size = header.lods_offset + static_cast<uint64_t>(header.lod_count) * sizeof(LodRange);
+
+    std::vector<uint8_t> file(header.file_size, 0);
+    std::memcpy(file.data(), &header, sizeof(Header));
+
+    uint8_t* vertex_data = file.data() + header.vertices_offset;
+    for (const auto& vertex : vertices) {
+        if (quantize) {
+            QuantizedVertex quantized{};
+            for (auto axis = 0U; axis < 3U; ++axis) {
+                quantized.position[axis] = quantize_unorm16(vertex.position[axis], header.position_min[axis], header.position_max[axis]);
+                quantized.normal[axis] = quantize_snorm8(vertex.normal[axis]);
+            }
+            for (auto axis = 0U; axis < 4U; ++axis) {
+                quantized.tangent[axis] = quantize_snorm8(vertex.tangent[axis]);
+            }
+            for (auto axis = 0U; axis < 2U; ++axis) {
+                quantized.texture_coordinates[axis] = quantize_unorm16(
+                    vertex.texture_coordinates[axis], header.texture_coordinates_min[axis], header.texture_coordinates_max[axis]
+                );
+            }
+            std::memcpy(vertex_data, &quantized, sizeof(QuantizedVertex));
+        } else {
+            std::memcpy(vertex_data, &vertex, sizeof(FullVertex));
+        }
+        vertex_data += header.vertex_stride;
+    }
+    std::memcpy(file.data() + header.indices_offset, indices.data(), indices.size() * sizeof(uint32_t));
+    std::memcpy(file.data() + header.lods_offset, lods.data(), lods.size() * sizeof(LodRange));
+
+    std::ofstream output(arguments[0], std::ios::binary);
+    output.write(reinterpret_cast<const char*>(file.data()), static_cast<std::streamsize>(file.size()));
+    if (!output) {
+        std::cerr << "Failed to write '" << arguments[0] << "'" << std::endl;
+        return 1;
+    }
+
+    std::cout << arguments[0] << ": " << header.vertex_count << " vertices, " << header.index_count << " indices, "
+              << header.lod_count << " LODs" << (quantize ? ", quantized" : "") << std::endl;
+
+    return 0;
+}
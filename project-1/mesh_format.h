@@ -0,0 +1,235 @@
+#ifndef MESH_FORMAT_H
+#define MESH_FORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#ifdef _WIN32
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+// Binary mesh files written by mesh_converter and read by the games.
+//
+// A file is a Header followed by blobs at the offsets it gives: the vertices,
+// the indices (32 bit) and the LOD ranges. Every blob starts at a multiple of
+// MESH_BLOB_ALIGNMENT, so a memory mapped file can be read in place. All
+// values are little endian. Every LOD is a range of the one index blob; its
+// indices point into the shared vertex blob.
+//
+// Vertices are either FullVertex records or, with MESH_FLAG_QUANTIZED,
+// QuantizedVertex records: positions and texture coordinates are unsigned
+// normalized 16 bit values inside the bounds stored in the header, normals
+// and tangents are signed normalized 8 bit values.
+//
+// Tangents are computed by the converter with tangent_frames.h and stored as
+// (x, y, z, bitangent sign). Version 1 files had no tangents and are no
+// longer read.
+
+namespace mesh_format {
+
+static const uint32_t MESH_MAGIC{ 0x4d525341U }; // "ASRM"
+static const uint32_t MESH_VERSION{ 2U };
+static const size_t MESH_BLOB_ALIGNMENT{ 16U };
+
+static const uint32_t MESH_FLAG_QUANTIZED{ 1U << 0U };
+
+struct Header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t flags;
+    uint32_t vertex_stride;
+
+    uint32_t vertex_count;
+    uint32_t index_count;
+    uint32_t lod_count;
+    uint32_t reserved;
+
+    uint64_t vertices_offset;
+    uint64_t indices_offset;
+    uint64_t lods_offset;
+    uint64_t file_size;
+
+    float position_min[3];
+    float position_max[3];
+    float texture_coordinates_min[2];
+    float texture_coordinates_max[2];
+    uint32_t padding[2];
+};
+
+struct FullVertex {
+    float position[3];
+    float normal[3];
+    float texture_coordinates[2];
+    float tangent[4];
+};
+
+struct QuantizedVertex {
+    uint16_t position[3];
+    int8_t normal[3];
+    int8_t padding;
+    uint16_t texture_coordinates[2];
+    int8_t tangent[4];
+};
+
+// Indices [first_index, first_index + index_count) are used while the
+// distance to the camera is below max_distance.
+struct LodRange {
+    uint32_t first_index;
+    uint32_t index_count;
+    float max_distance;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(Header) % MESH_BLOB_ALIGNMENT == 0, "blobs follow the header aligned");
+static_assert(sizeof(FullVertex) == 48, "vertex records are packed");
+static_assert(sizeof(QuantizedVertex) == 18, "vertex records are packed");
+static_assert(sizeof(LodRange) == 16, "LOD records are packed");
+
+[[nodiscard]] inline uint64_t align_blob_offset(uint64_t offset)
+{
+    return (offset + MESH_BLOB_ALIGNMENT - 1U) / MESH_BLOB_ALIGNMENT * MESH_BLOB_ALIGNMENT;
+}
+
+[[nodiscard]] inline float dequantize_unorm16(uint16_t value, float min, float max)
+{
+    return min + (max - min) * (static_cast<float>(value) / 65535.0f);
+}
+
+[[nodiscard]] inline float dequantize_snorm8(int8_t value)
+{
+    float result = static_cast<float>(value) / 127.0f;
+    return result < -1.0f ? -1.0f : result;
+}
+
+// Read-only mapping of a whole file. is_open() is false when the file does
+// not exist or cannot be mapped.
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path)
+    {
+#ifdef _WIN32
+        _file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (_file == INVALID_HANDLE_VALUE) {
+            return;
+        }
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(_file, &size) || size.QuadPart == 0) {
+            return;
+        }
+        _mapping = CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (_mapping == nullptr) {
+            return;
+        }
+        _data = MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0);
+        if (_data != nullptr) {
+            _size = static_cast<size_t>(size.QuadPart);
+        }
+#else
+        int file = open(path.c_str(), O_RDONLY);
+        if (file < 0) {
+            return;
+        }
+        struct stat status{};
+        if (fstat(file, &status) == 0 && status.st_size > 0) {
+            void* data = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+            if (data != MAP_FAILED) {
+                _data = data;
+                _size = static_cast<size_t>(status.st_size);
+            }
+        }
+        close(file);
+#endif
+    }
+
+    ~MappedFile()
+    {
+#ifdef _WIN32
+        if (_data != nullptr) {
+            UnmapViewOfFile(_data);
+        }
+        if (_mapping != nullptr) {
+            CloseHandle(_mapping);
+        }
+        if (_file != INVALID_HANDLE_VALUE) {
+            CloseHandle(_file);
+        }
+#else
+        if (_data != nullptr) {
+            munmap(_data, _size);
+        }
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    [[nodiscard]] bool is_open() const
+    {
+        return _data != nullptr;
+    }
+
+    [[nodiscard]] const uint8_t* get_data() const
+    {
+        return static_cast<const uint8_t*>(_data);
+    }
+
+    [[nodiscard]] size_t get_size() const
+    {
+        return _size;
+    }
+
+private:
+    void* _data{ nullptr };
+    size_t _size{ 0 };
+#ifdef _WIN32
+    HANDLE _file{ INVALID_HANDLE_VALUE };
+    HANDLE _mapping{ nullptr };
+#endif
+};
+
+// Checks that the header is ours and that every blob lies inside the file.
+[[nodiscard]] inline const Header* validate_mesh_file(const uint8_t* data, size_t size)
+{
+    if (data == nullptr || size < sizeof(Header)) {
+        return nullptr;
+    }
+    const auto* header = reinterpret_cast<const Header*>(data);
+    if (header->magic != MESH_MAGIC || header->version != MESH_VERSION || header->file_size != size) {
+        return nullptr;
+    }
+
+    size_t stride = (header->flags & MESH_FLAG_QUANTIZED) != 0U ? sizeof(QuantizedVertex) : sizeof(FullVertex);
+    auto fits = [size](uint64_t offset, uint64_t bytes) {
+        return offset % MESH_BLOB_ALIGNMENT == 0 && offset <= size && bytes <= size - offset;
+    };
+    if (header->vertex_stride != stride ||
+        !fits(header->vertices_offset, static_cast<uint64_t>(header->vertex_count) * stride) ||
+        !fits(header->indices_offset, static_cast<uint64_t>(header->index_count) * sizeof(uint32_t)) ||
+        !fits(header->lods_offset, static_cast<uint64_t>(header->lod_count) * sizeof(LodRange)) ||
+        header->lod_count == 0) {
+        return nullptr;
+    }
+
+    const auto* lods = reinterpret_cast<const LodRange*>(data + header->lods_offset);
+    for (uint32_t lod = 0; lod < header->lod_count; ++lod) {
+        if (static_cast<uint64_t>(lods[lod].first_index) + lods[lod].index_count > header->index_count) {
+            return nullptr;
+        }
+    }
+
+    return header;
+}
+
+}
+
+#endif
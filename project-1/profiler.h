@@ -0,0 +1,197 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#ifndef GAME_TEST_PROFILING
+    #define GAME_TEST_PROFILING 1
+#endif
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    #define GAME_TEST_RDTSC 1
+    #include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+    #define GAME_TEST_RDTSC 1
+    #include <x86intrin.h>
+#else
+    #define GAME_TEST_RDTSC 0
+#endif
+
+static const size_t PROFILER_ZONES_PER_THREAD{ 1U << 16U };
+static const size_t PROFILER_FRAME_HISTORY{ 240U };
+
+// Scoped-zone profiler. Every thread records the zones it closes into its
+// own ring buffer without locking, overwriting the oldest ones when it is
+// full. Timestamps are time stamp counter ticks where there is one and are
+// converted to microseconds only on export, which writes the Chrome trace
+// event format (chrome://tracing, ui.perfetto.dev). Exporting while other
+// threads record may catch a zone being overwritten. PROFILE_ZONE compiles
+// to nothing with GAME_TEST_PROFILING set to 0.
+class Profiler {
+public:
+    [[nodiscard]] static Profiler& get_instance()
+    {
+        static Profiler profiler;
+        return profiler;
+    }
+
+    [[nodiscard]] static uint64_t read_timestamp()
+    {
+#if GAME_TEST_RDTSC
+        return __rdtsc();
+#else
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()
+        ).count());
+#endif
+    }
+
+    void record(const char* name, uint64_t start, uint64_t end)
+    {
+        ThreadBuffer& buffer = _get_thread_buffer();
+        uint64_t index = buffer.written.load(std::memory_order_relaxed);
+        buffer.zones[index % PROFILER_ZONES_PER_THREAD] = Zone{ name, start, end };
+        buffer.written.store(index + 1, std::memory_order_release);
+    }
+
+    // Called once per frame on the main thread.
+    void end_frame()
+    {
+        auto now = std::chrono::steady_clock::now();
+        if (_frame_count > 0) {
+            std::chrono::duration<float, std::milli> frame_time = now - _frame_started;
+            _frame_times[_frame_index] = frame_time.count();
+            _frame_index = (_frame_index + 1) % PROFILER_FRAME_HISTORY;
+        }
+        _frame_started = now;
+        ++_frame_count;
+    }
+
+    [[nodiscard]] const std::array<float, PROFILER_FRAME_HISTORY>& get_frame_times() const
+    {
+        return _frame_times;
+    }
+
+    // Index of the oldest entry of get_frame_times().
+    [[nodiscard]] size_t get_frame_times_offset() const
+    {
+        return _frame_index;
+    }
+
+    bool write_chrome_trace(const std::string& file)
+    {
+        double ticks_per_microsecond = _get_ticks_per_microsecond();
+
+        // Microseconds with nanosecond decimals: the default six significant
+        // digits round timestamps to tens of microseconds after a second.
+        std::ofstream output(file);
+        output << std::fixed << std::setprecision(3);
+        output << "{\"traceEvents\":[";
+        bool first{ true };
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (const auto& buffer : _buffers) {
+            uint64_t written = buffer->written.load(std::memory_order_acquire);
+            uint64_t count = std::min<uint64_t>(written, PROFILER_ZONES_PER_THREAD);
+            for (uint64_t index = written - count; index < written; ++index) {
+                const Zone& zone = buffer->zones[index % PROFILER_ZONES_PER_THREAD];
+                if (zone.start < _start_timestamp || zone.end < zone.start) {
+                    continue;
+                }
+                output << (first ? "" : ",") << "\n{\"name\":\"" << zone.name << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << buffer->thread
+                       << ",\"ts\":" << static_cast<double>(zone.start - _start_timestamp) / ticks_per_microsecond
+                       << ",\"dur\":" << static_cast<double>(zone.end - zone.start) / ticks_per_microsecond << "}";
+                first = false;
+            }
+        }
+        output << "\n]}\n";
+
+        return output.good();
+    }
+
+private:
+    struct Zone {
+        const char* name;
+        uint64_t start, end;
+    };
+
+    struct ThreadBuffer {
+        std::array<Zone, PROFILER_ZONES_PER_THREAD> zones;
+        std::atomic<uint64_t> written{ 0 };
+        unsigned int thread{ 0 };
+    };
+
+    std::mutex _mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> _buffers;
+
+    uint64_t _start_timestamp{ read_timestamp() };
+    std::chrono::steady_clock::time_point _start_time{ std::chrono::steady_clock::now() };
+
+    std::array<float, PROFILER_FRAME_HISTORY> _frame_times{};
+    size_t _frame_index{ 0 };
+    uint64_t _frame_count{ 0 };
+    std::chrono::steady_clock::time_point _frame_started;
+
+    Profiler() = default;
+
+    ThreadBuffer& _get_thread_buffer()
+    {
+        thread_local ThreadBuffer* buffer{ nullptr };
+        if (buffer == nullptr) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _buffers.push_back(std::make_unique<ThreadBuffer>());
+            buffer = _buffers.back().get();
+            buffer->thread = static_cast<unsigned int>(_buffers.size() - 1);
+        }
+
+        return *buffer;
+    }
+
+    // The counter rate is measured against the steady clock since startup.
+    [[nodiscard]] double _get_ticks_per_microsecond() const
+    {
+        std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - _start_time;
+        uint64_t ticks = read_timestamp() - _start_timestamp;
+
+        return elapsed.count() > 0.0 && ticks > 0 ? static_cast<double>(ticks) / elapsed.count() : 1.0;
+    }
+};
+
+class ProfileZone {
+public:
+    explicit ProfileZone(const char* name) : _name{ name }, _start{ Profiler::read_timestamp() }
+    { }
+
+    ~ProfileZone()
+    {
+        Profiler::get_instance().record(_name, _start, Profiler::read_timestamp());
+    }
+
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+    const char* _name;
+    uint64_t _start;
+};
+
+#if GAME_TEST_PROFILING
+    #define PROFILE_ZONE_NAME_(line) profile_zone_##line
+    #define PROFILE_ZONE_NAME(line) PROFILE_ZONE_NAME_(line)
+    #define PROFILE_ZONE(name) ProfileZone PROFILE_ZONE_NAME(__LINE__){ name }
+#else
+    #define PROFILE_ZONE(name) static_cast<void>(0)
+#endif
+
+#endif
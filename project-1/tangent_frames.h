@@ -0,0 +1,237 @@
+#ifndef TANGENT_FRAMES_H
+#define TANGENT_FRAMES_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define TANGENT_FRAMES_SSE 1
+    #include <emmintrin.h>
+#else
+    #define TANGENT_FRAMES_SSE 0
+#endif
+
+// Per-vertex tangent frames for normal mapping, computed once when a mesh is
+// created instead of being rebuilt from derivatives in every fragment.
+//
+// The result follows the MikkTSpace conventions: every tangent is a unit
+// vector orthogonal to the vertex normal, stored as (x, y, z, sign) where the
+// bitangent is sign * cross(normal, tangent). Triangle tangents and
+// bitangents come from the texture coordinate gradients, are normalized and
+// weighted by the corner angle before they are summed per vertex, so the
+// frames do not depend on how a surface is triangulated. Vertices are not
+// split where the sign changes; mirrored seams need split vertices already.
+
+namespace tangent_frames {
+
+namespace detail {
+
+struct Vector {
+    float x, y, z;
+};
+
+inline Vector load(const float* data, size_t stride, size_t index)
+{
+    const float* values = reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(data) + index * stride);
+    return Vector{ values[0], values[1], values[2] };
+}
+
+inline Vector subtract(const Vector& a, const Vector& b)
+{
+    return Vector{ a.x - b.x, a.y - b.y, a.z - b.z };
+}
+
+inline float dot(const Vector& a, const Vector& b)
+{
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+inline Vector normalize(const Vector& v)
+{
+    float length = std::sqrt(dot(v, v));
+    return length > 0.0f ? Vector{ v.x / length, v.y / length, v.z / length } : Vector{ 0.0f, 0.0f, 0.0f };
+}
+
+// Gram-Schmidt against the normal, then the bitangent sign. Vertices without
+// usable texture coordinates get any tangent orthogonal to their normal, and
+// (1, 0, 0, +1) when they have no normal either.
+inline void finish_vertex(
+    float nx, float ny, float nz, float tx, float ty, float tz, float bx, float by, float bz, float* tangent
+)
+{
+    float n_dot_t = nx * tx + ny * ty + nz * tz;
+    tx -= nx * n_dot_t;
+    ty -= ny * n_dot_t;
+    tz -= nz * n_dot_t;
+    float length = std::sqrt(tx * tx + ty * ty + tz * tz);
+    if (length < 1e-6f) {
+        if (std::abs(nx) < 0.9f) {
+            tx = 0.0f; ty = nz; tz = -ny;
+        } else {
+            tx = -nz; ty = 0.0f; tz = nx;
+        }
+        length = std::sqrt(tx * tx + ty * ty + tz * tz);
+        if (length < 1e-6f) {
+            tx = 1.0f; ty = 0.0f; tz = 0.0f;
+            length = 1.0f;
+        }
+    }
+    tx /= length;
+    ty /= length;
+    tz /= length;
+
+    float cx = ny * tz - nz * ty, cy = nz * tx - nx * tz, cz = nx * ty - ny * tx;
+    tangent[0] = tx;
+    tangent[1] = ty;
+    tangent[2] = tz;
+    tangent[3] = cx * bx + cy * by + cz * bz < 0.0f ? -1.0f : 1.0f;
+}
+
+}
+
+// Positions and normals are three floats, texture coordinates two, each
+// read from its own pointer with the given byte stride, so interleaved
+// vertex structures can be passed directly. Writes four floats per vertex.
+inline void compute_tangent_frames(
+    const float* positions, const float* normals, const float* texture_coordinates, size_t stride, size_t vertex_count,
+    const uint32_t* indices, size_t index_count, float* tangents
+)
+{
+    using namespace detail;
+
+    // Sums are kept as separate arrays so the per-vertex pass below can work
+    // on four vertices at once.
+    std::vector<float> sums(vertex_count * 9U, 0.0f);
+    float* tangent_x = sums.data();
+    float* tangent_y = tangent_x + vertex_count;
+    float* tangent_z = tangent_y + vertex_count;
+    float* bitangent_x = tangent_z + vertex_count;
+    float* bitangent_y = bitangent_x + vertex_count;
+    float* bitangent_z = bitangent_y + vertex_count;
+    float* normal_x = bitangent_z + vertex_count;
+    float* normal_y = normal_x + vertex_count;
+    float* normal_z = normal_y + vertex_count;
+
+    for (size_t i = 0; i < vertex_count; ++i) {
+        Vector normal = normalize(load(normals, stride, i));
+        normal_x[i] = normal.x;
+        normal_y[i] = normal.y;
+        normal_z[i] = normal.z;
+    }
+
+    for (size_t i = 0; i + 2 < index_count; i += 3) {
+        const uint32_t corners[3]{ indices[i], indices[i + 1], indices[i + 2] };
+        if (corners[0] >= vertex_count || corners[1] >= vertex_count || corners[2] >= vertex_count) {
+            continue;
+        }
+
+        Vector p[3], uv[3];
+        for (int corner = 0; corner < 3; ++corner) {
+            p[corner] = load(positions, stride, corners[corner]);
+            const float* coordinates = reinterpret_cast<const float*>(
+                reinterpret_cast<const uint8_t*>(texture_coordinates) + corners[corner] * stride
+            );
+            uv[corner] = Vector{ coordinates[0], coordinates[1], 0.0f };
+        }
+
+        Vector edge1 = subtract(p[1], p[0]), edge2 = subtract(p[2], p[0]);
+        float du1 = uv[1].x - uv[0].x, dv1 = uv[1].y - uv[0].y;
+        float du2 = uv[2].x - uv[0].x, dv2 = uv[2].y - uv[0].y;
+        float area = du1 * dv2 - du2 * dv1;
+        if (std::abs(area) < 1e-12f) {
+            continue;
+        }
+        float orientation = area > 0.0f ? 1.0f : -1.0f;
+        Vector tangent = normalize(Vector{
+            (edge1.x * dv2 - edge2.x * dv1) * orientation,
+            (edge1.y * dv2 - edge2.y * dv1) * orientation,
+            (edge1.z * dv2 - edge2.z * dv1) * orientation
+        });
+        Vector bitangent = normalize(Vector{
+            (edge2.x * du1 - edge1.x * du2) * orientation,
+            (edge2.y * du1 - edge1.y * du2) * orientation,
+            (edge2.z * du1 - edge1.z * du2) * orientation
+        });
+
+        for (int corner = 0; corner < 3; ++corner) {
+            Vector to_next = normalize(subtract(p[(corner + 1) % 3], p[corner]));
+            Vector to_previous = normalize(subtract(p[(corner + 2) % 3], p[corner]));
+            float cosine = dot(to_next, to_previous);
+            float angle = std::acos(cosine < -1.0f ? -1.0f : (cosine > 1.0f ? 1.0f : cosine));
+
+            uint32_t vertex = corners[corner];
+            tangent_x[vertex] += tangent.x * angle;
+            tangent_y[vertex] += tangent.y * angle;
+            tangent_z[vertex] += tangent.z * angle;
+            bitangent_x[vertex] += bitangent.x * angle;
+            bitangent_y[vertex] += bitangent.y * angle;
+            bitangent_z[vertex] += bitangent.z * angle;
+        }
+    }
+
+    size_t i{ 0 };
+
+#if TANGENT_FRAMES_SSE
+    const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f), minimum_length = _mm_set1_ps(1e-12f);
+    const __m128 sign_bit = _mm_set1_ps(-0.0f);
+    for (; i + 4 <= vertex_count; i += 4) {
+        __m128 nx = _mm_loadu_ps(normal_x + i), ny = _mm_loadu_ps(normal_y + i), nz = _mm_loadu_ps(normal_z + i);
+        __m128 tx = _mm_loadu_ps(tangent_x + i), ty = _mm_loadu_ps(tangent_y + i), tz = _mm_loadu_ps(tangent_z + i);
+
+        __m128 n_dot_t = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, tx), _mm_mul_ps(ny, ty)), _mm_mul_ps(nz, tz));
+        tx = _mm_sub_ps(tx, _mm_mul_ps(nx, n_dot_t));
+        ty = _mm_sub_ps(ty, _mm_mul_ps(ny, n_dot_t));
+        tz = _mm_sub_ps(tz, _mm_mul_ps(nz, n_dot_t));
+        __m128 length_squared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(tx, tx), _mm_mul_ps(ty, ty)), _mm_mul_ps(tz, tz));
+
+        // Degenerate frames are rare; finish those four vertices the slow way.
+        // That includes a zero normal without usable texture coordinates,
+        // which leaves a zero tangent here. A zero normal with a tangent
+        // passes through unchanged and gets the sign +1.
+        if (_mm_movemask_ps(_mm_cmplt_ps(length_squared, minimum_length)) != 0) {
+            for (size_t j = i; j < i + 4; ++j) {
+                finish_vertex(
+                    normal_x[j], normal_y[j], normal_z[j], tangent_x[j], tangent_y[j], tangent_z[j],
+                    bitangent_x[j], bitangent_y[j], bitangent_z[j], tangents + j * 4U
+                );
+            }
+            continue;
+        }
+
+        __m128 inverse_length = _mm_div_ps(one, _mm_sqrt_ps(length_squared));
+        tx = _mm_mul_ps(tx, inverse_length);
+        ty = _mm_mul_ps(ty, inverse_length);
+        tz = _mm_mul_ps(tz, inverse_length);
+
+        __m128 cx = _mm_sub_ps(_mm_mul_ps(ny, tz), _mm_mul_ps(nz, ty));
+        __m128 cy = _mm_sub_ps(_mm_mul_ps(nz, tx), _mm_mul_ps(nx, tz));
+        __m128 cz = _mm_sub_ps(_mm_mul_ps(nx, ty), _mm_mul_ps(ny, tx));
+        __m128 handedness = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(cx, _mm_loadu_ps(bitangent_x + i)), _mm_mul_ps(cy, _mm_loadu_ps(bitangent_y + i))),
+            _mm_mul_ps(cz, _mm_loadu_ps(bitangent_z + i))
+        );
+        __m128 sign = _mm_or_ps(one, _mm_and_ps(_mm_cmplt_ps(handedness, zero), sign_bit));
+
+        // Transpose the four frames back into (x, y, z, sign) records.
+        __m128 xy_low = _mm_unpacklo_ps(tx, ty), xy_high = _mm_unpackhi_ps(tx, ty);
+        __m128 zs_low = _mm_unpacklo_ps(tz, sign), zs_high = _mm_unpackhi_ps(tz, sign);
+        _mm_storeu_ps(tangents + i * 4U, _mm_movelh_ps(xy_low, zs_low));
+        _mm_storeu_ps(tangents + i * 4U + 4U, _mm_movehl_ps(zs_low, xy_low));
+        _mm_storeu_ps(tangents + i * 4U + 8U, _mm_movelh_ps(xy_high, zs_high));
+        _mm_storeu_ps(tangents + i * 4U + 12U, _mm_movehl_ps(zs_high, xy_high));
+    }
+#endif
+
+    for (; i < vertex_count; ++i) {
+        finish_vertex(
+            normal_x[i], normal_y[i], normal_z[i], tangent_x[i], tangent_y[i], tangent_z[i],
+            bitangent_x[i], bitangent_y[i], bitangent_z[i], tangents + i * 4U
+        );
+    }
+}
+
+}
+
+#endif